@@ -0,0 +1,88 @@
+#ifndef HF_BENCH_H_
+#define HF_BENCH_H_
+
+/* Minimal timing support for the benchmark programs in this directory.
+ *
+ * `run(name, items, f)` calls `f()` a few times and prints the best wall
+ * clock time per item, in nanoseconds; `run_with(name, items, setup, f)`
+ * times only `f(s)`, for `s` freshly returned by `setup()` each time. Programs take an optional scale
+ * factor as their first argument, multiplying their default problem
+ * sizes, which are chosen to run in well under a second.
+ *
+ * `keep(x)` and `clobber()` stop the compiler from discarding or
+ * hoisting the work being measured (GCC and Clang only).
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace bench {
+
+// Make `x` appear to be read, so that computing it is not optimized away.
+template <typename T>
+inline void keep(const T& x) {
+    asm volatile("" : : "r"(&x) : "memory");
+}
+
+// Make all memory appear to be read and written.
+inline void clobber() {
+    asm volatile("" : : : "memory");
+}
+
+// Problem size `n`, multiplied by the scale factor given on the command line.
+inline std::size_t size(int argc, char** argv, std::size_t n) {
+    double scale=argc>1? std::atof(argv[1]): 1.0;
+    return scale>0? static_cast<std::size_t>(n*scale): n;
+}
+
+inline void heading(const char* title) {
+    std::printf("\n%s\n", title);
+}
+
+inline double report(const char* name, std::size_t items, double best) {
+    double per_item=items? best/items: best;
+    std::printf("  %-40s %10.2f ns\n", name, per_item);
+    return per_item;
+}
+
+// Best of `repeat` runs of `f()`, reported per item.
+template <typename F>
+double run(const char* name, std::size_t items, F&& f, int repeat=5) {
+    typedef std::chrono::steady_clock clock;
+    double best=0;
+
+    for (int r=0; r<repeat; ++r) {
+        auto t0=clock::now();
+        f();
+        clobber();
+        double t=std::chrono::duration<double, std::nano>(clock::now()-t0).count();
+        if (r==0 || t<best) best=t;
+    }
+    return report(name, items, best);
+}
+
+// As `run`, calling `f(s)` on the result `s` of `setup()`; neither
+// `setup()` nor the destruction of `s` is timed.
+template <typename S, typename F>
+double run_with(const char* name, std::size_t items, S&& setup, F&& f, int repeat=5) {
+    typedef std::chrono::steady_clock clock;
+    double best=0;
+
+    for (int r=0; r<repeat; ++r) {
+        auto s=setup();
+        clobber();
+        auto t0=clock::now();
+        f(s);
+        clobber();
+        double t=std::chrono::duration<double, std::nano>(clock::now()-t0).count();
+        if (r==0 || t<best) best=t;
+    }
+    return report(name, items, best);
+}
+
+} // namespace bench
+
+#endif // ndef HF_BENCH_H_
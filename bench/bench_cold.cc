@@ -0,0 +1,89 @@
+// Returning either<long, E> by value, with a large error type E held
+// inline or out of line as cold<E>, when every call succeeds and when
+// one call in a hundred fails; and scanning arrays of the results,
+// whose size is that of the either.
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <optionalm/cold.h>
+#include <optionalm/either.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+struct big_error {
+    std::string message;
+    std::array<int, 32> context;
+
+    explicit big_error(std::string m): message(std::move(m)), context() {}
+};
+
+typedef either<long, big_error> inline_result;
+typedef either<long, cold<big_error>> cold_result;
+
+__attribute__((noinline)) inline_result inline_step(long i, long fail) {
+    if (i%fail==0) return big_error("step failed");
+    return i;
+}
+
+__attribute__((noinline)) cold_result cold_step(long i, long fail) {
+    if (i%fail==0) return big_error("step failed");
+    return i;
+}
+
+template <typename Result>
+long sum(const std::vector<Result>& v) {
+    long s=0;
+    for (const Result& r: v) s+=r.index()==0? r.template unsafe_get<0>(): -1;
+    return s;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 1000000);
+
+    std::printf("sizeof(either<long, big_error>)       = %zu\n", sizeof(inline_result));
+    std::printf("sizeof(either<long, cold<big_error>>) = %zu\n", sizeof(cold_result));
+
+    // `fail` larger than n means no call fails.
+    const long fails[]={long(n)+1, 100};
+    for (long fail: fails) {
+        bench::heading(fail>long(n)? "return by value, no errors, per call": "return by value, 1% errors, per call");
+
+        bench::run("inline error", n, [&]() {
+            long s=0;
+            for (std::size_t i=1; i<=n; ++i) {
+                inline_result r=inline_step(long(i), fail);
+                s+=r.index()==0? r.unsafe_get<0>(): -1;
+            }
+            bench::keep(s);
+        });
+
+        bench::run("cold error", n, [&]() {
+            long s=0;
+            for (std::size_t i=1; i<=n; ++i) {
+                cold_result r=cold_step(long(i), fail);
+                s+=r.index()==0? r.unsafe_get<0>(): -1;
+            }
+            bench::keep(s);
+        });
+    }
+
+    bench::heading("scan of stored results, no errors, per element");
+
+    std::vector<inline_result> inline_results;
+    std::vector<cold_result> cold_results;
+    inline_results.reserve(n);
+    cold_results.reserve(n);
+    for (std::size_t i=1; i<=n; ++i) {
+        inline_results.push_back(long(i));
+        cold_results.push_back(long(i));
+    }
+
+    bench::run("inline error", n, [&]() { bench::keep(sum(inline_results)); });
+    bench::run("cold error", n, [&]() { bench::keep(sum(cold_results)); });
+}
@@ -0,0 +1,70 @@
+// Short-circuiting over a chain of optional-returning steps: coroutine
+// style against the equivalent bind chain and a hand-written if-chain.
+
+#include <cstdio>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/coroutine.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+#if defined(__cpp_impl_coroutine)
+
+// Unset for multiples of 97, so that about one chain in 25 fails.
+__attribute__((noinline)) optional<int> step(int x) {
+    if (x%97==0) return nothing;
+    return x+3;
+}
+
+optional<int> chain_coroutine(int x) {
+    int a=co_await step(x);
+    int b=co_await step(a);
+    int c=co_await step(b);
+    int d=co_await step(c);
+    co_return d;
+}
+
+optional<int> chain_bind(int x) {
+    return step(x) >> [](int a) { return step(a); } >> [](int b) { return step(b); } >> [](int c) { return step(c); };
+}
+
+optional<int> chain_if(int x) {
+    optional<int> a=step(x);
+    if (!a) return nothing;
+    optional<int> b=step(*a);
+    if (!b) return nothing;
+    optional<int> c=step(*b);
+    if (!c) return nothing;
+    return step(*c);
+}
+
+template <typename F>
+void time_chain(const char* name, std::size_t n, F f) {
+    bench::run(name, n, [&]() {
+        long sum=0;
+        for (std::size_t i=0; i<n; ++i) {
+            if (auto r=f(int(i))) sum+=*r;
+        }
+        bench::keep(sum);
+    });
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 2000000);
+
+    bench::heading("four-step optional chain");
+    time_chain("if-chain", n, chain_if);
+    time_chain("bind chain", n, chain_bind);
+    time_chain("coroutine", n, chain_coroutine);
+}
+
+#else
+
+int main() {
+    std::puts("bench_coroutine requires C++20 coroutine support");
+}
+
+#endif
@@ -0,0 +1,56 @@
+// Scanning arrays of eithers of references, whose discriminant is packed
+// into the pointer (8 bytes), against eithers of the equivalent pointers,
+// which carry a separate discriminant (16 bytes).
+
+#include <cstddef>
+#include <vector>
+
+#include <optionalm/either.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+typedef either<int&, double&> packed_either;
+typedef either<int*, double*> unpacked_either;
+
+static_assert(sizeof(packed_either)==sizeof(void*), "discriminant packed into pointer");
+static_assert(sizeof(unpacked_either)==2*sizeof(void*), "separate discriminant");
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 4000000);
+
+    // Referenced values are few, so that they stay in cache and the
+    // scan is bound by the size of the eithers.
+    std::vector<int> ints(64, 1);
+    std::vector<double> doubles(64, 0.5);
+
+    std::vector<packed_either> packed;
+    std::vector<unpacked_either> unpacked;
+    packed.reserve(n);
+    unpacked.reserve(n);
+
+    for (std::size_t i=0; i<n; ++i) {
+        std::size_t k=(i*2654435761u)>>7;
+        if (k%2) {
+            packed.push_back(packed_either(ints[k%64]));
+            unpacked.push_back(unpacked_either(&ints[k%64]));
+        }
+        else {
+            packed.push_back(packed_either(doubles[k%64]));
+            unpacked.push_back(unpacked_either(&doubles[k%64]));
+        }
+    }
+
+    bench::heading("sum over an array of eithers, per element");
+    bench::run("either<int&, double&> (packed)", n, [&]() {
+        double sum=0;
+        for (auto& e: packed) sum+=e.index()==0? e.unsafe_get<0>(): e.unsafe_get<1>();
+        bench::keep(sum);
+    });
+    bench::run("either<int*, double*>", n, [&]() {
+        double sum=0;
+        for (auto& e: unpacked) sum+=e.index()==0? *e.unsafe_get<0>(): *e.unsafe_get<1>();
+        bench::keep(sum);
+    });
+}
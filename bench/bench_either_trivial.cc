@@ -0,0 +1,52 @@
+// Passing and returning either<int, double> by value through calls that
+// are not inlined, against an either with a non-trivial alternative of
+// the same layout, which is passed and returned through memory.
+
+#include <cstddef>
+
+#include <optionalm/either.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+// A double with a user-provided copy constructor.
+struct boxed {
+    double d;
+    boxed(double d): d(d) {}
+    boxed(const boxed& b): d(b.d) {}
+};
+
+typedef either<int, double> trivial_either;
+typedef either<int, boxed> nontrivial_either;
+
+static_assert(std::is_trivially_copyable<trivial_either>::value, "trivial alternatives");
+static_assert(!std::is_trivially_copyable<nontrivial_either>::value, "non-trivial alternative");
+static_assert(sizeof(trivial_either)==sizeof(nontrivial_either), "same layout");
+
+__attribute__((noinline)) trivial_either step(trivial_either e) {
+    if (e.index()==0) return e.unsafe_get<0>()%3? trivial_either(e.unsafe_get<0>()+1): trivial_either(in_place_index_t<1>{}, 0.5*e.unsafe_get<0>());
+    return trivial_either(int(e.unsafe_get<1>()));
+}
+
+__attribute__((noinline)) nontrivial_either step(nontrivial_either e) {
+    if (e.index()==0) return e.unsafe_get<0>()%3? nontrivial_either(e.unsafe_get<0>()+1): nontrivial_either(in_place_index_t<1>{}, 0.5*e.unsafe_get<0>());
+    return nontrivial_either(int(e.unsafe_get<1>().d));
+}
+
+template <typename E>
+void time_calls(const char* name, std::size_t n) {
+    bench::run(name, n, [&]() {
+        E e(1);
+        for (std::size_t i=0; i<n; ++i) e=step(e);
+        bench::keep(e);
+    });
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 10000000);
+
+    bench::heading("call passing and returning an either by value");
+    time_calls<trivial_either>("either<int, double>", n);
+    time_calls<nontrivial_either>("either<int, boxed double>", n);
+}
@@ -0,0 +1,64 @@
+// Processing a random 50/50 mix of int and double alternatives stored
+// in an either_vector, against a std::vector of eithers.
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <optionalm/either.h>
+#include <optionalm/either_vector.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+typedef either<int, double> value;
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 4000000);
+
+    std::minstd_rand rng(42);
+    std::bernoulli_distribution coin(0.5);
+
+    std::vector<value> input;
+    input.reserve(n);
+    for (std::size_t i=0; i<n; ++i) {
+        if (coin(rng)) input.push_back(value(int(i%1000)));
+        else input.push_back(value(in_place_index_t<1>{}, 0.5*(i%1000)));
+    }
+
+    bench::heading("building from a random 50/50 mix, per element");
+    bench::run("std::vector<either<int, double>>", n, [&]() {
+        std::vector<value> v;
+        for (auto& x: input) v.push_back(x);
+        bench::keep(v.data());
+    });
+    bench::run("either_vector<int, double>", n, [&]() {
+        either_vector<int, double> v;
+        for (auto& x: input) v.push_back(x);
+        bench::keep(v);
+    });
+
+    std::vector<value> vec(input);
+    either_vector<int, double> ev(input.begin(), input.end());
+
+    bench::heading("summing ints and doubles separately, per element");
+    bench::run("std::vector, branch per element", n, [&]() {
+        long isum=0;
+        double dsum=0;
+        for (auto& x: vec) {
+            if (x.index()==0) isum+=x.unsafe_get<0>();
+            else dsum+=x.unsafe_get<1>();
+        }
+        bench::keep(isum);
+        bench::keep(dsum);
+    });
+    bench::run("either_vector, for_each_left/right", n, [&]() {
+        long isum=0;
+        double dsum=0;
+        ev.for_each_left([&](int x) { isum+=x; });
+        ev.for_each_right([&](double x) { dsum+=x; });
+        bench::keep(isum);
+        bench::keep(dsum);
+    });
+}
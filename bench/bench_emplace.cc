@@ -0,0 +1,51 @@
+// Building optionals of a large payload: from a temporary, which costs
+// an extra move, against in-place construction and `emplace`.
+
+#include <cstddef>
+
+#include <optionalm/optional.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+struct large {
+    double data[128];
+
+    explicit large(double x) {
+        for (auto& d: data) d=x;
+    }
+};
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 200000);
+
+    bench::heading("constructing optional<large> (1 KiB payload)");
+    bench::run("optional<large>(large(x))", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            optional<large> o{large(double(i))};
+            bench::keep(o);
+        }
+    });
+    bench::run("optional<large>(in_place, x)", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            optional<large> o(in_place, double(i));
+            bench::keep(o);
+        }
+    });
+
+    bench::heading("replacing the value of an optional<large>");
+    optional<large> o;
+    bench::run("o=large(x)", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            o=large(double(i));
+            bench::keep(o);
+        }
+    });
+    bench::run("o.emplace(x)", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            o.emplace(double(i));
+            bench::keep(o);
+        }
+    });
+}
@@ -0,0 +1,51 @@
+// Hash throughput over arrays of optional<int>: std::hash element by
+// element, hash_batch and, from C++17, std::hash of std::optional<int>
+// (which does not mix its input) for reference.
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <optionalm/hash.h>
+
+#if __cplusplus>=201703L
+#include <optional>
+#endif
+
+#include "bench.h"
+
+using namespace hf;
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 4000000);
+
+    std::vector<optional<int>> opts(n);
+    for (std::size_t i=0; i<n; ++i) {
+        if (i%5) opts[i]=int(i*2654435761u);
+    }
+    std::vector<std::size_t> hashes(n);
+
+    bench::heading("hashing optional<int>, per element");
+    bench::run("std::hash, element by element", n, [&]() {
+        std::hash<optional<int>> h;
+        for (std::size_t i=0; i<n; ++i) hashes[i]=h(opts[i]);
+        bench::keep(hashes.data());
+    });
+    bench::run("hash_batch", n, [&]() {
+        hash_batch(opts.begin(), opts.end(), hashes.begin());
+        bench::keep(hashes.data());
+    });
+
+#if __cplusplus>=201703L
+    std::vector<std::optional<int>> sopts(n);
+    for (std::size_t i=0; i<n; ++i) {
+        if (opts[i]) sopts[i]=*opts[i];
+    }
+
+    bench::run("std::hash<std::optional<int>>", n, [&]() {
+        std::hash<std::optional<int>> h;
+        for (std::size_t i=0; i<n; ++i) hashes[i]=h(sopts[i]);
+        bench::keep(hashes.data());
+    });
+#endif
+}
@@ -0,0 +1,67 @@
+// Combining three optional arguments with lift and apply, against the
+// equivalent nested binds and a hand-written test of each argument.
+
+#include <cstddef>
+#include <vector>
+
+#include <optionalm/optional.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 1000000);
+
+    // One in eight arguments unset, in no particular pattern.
+    std::vector<optional<int>> a(n), b(n), c(n);
+    unsigned r=12345;
+    for (std::size_t i=0; i<n; ++i) {
+        r=r*1103515245u+12345u;
+        if (r>>29) a[i]=int(i);
+        r=r*1103515245u+12345u;
+        if (r>>29) b[i]=int(i>>1);
+        r=r*1103515245u+12345u;
+        if (r>>29) c[i]=int(i>>2);
+    }
+
+    auto f=[](int x, int y, int z) { return x*y+z; };
+    auto g=[](const optional<int>& o) { return o? o.get(): 0; };
+
+    bench::heading("three-argument call, per element");
+
+    bench::run("explicit tests", n, [&]() {
+        int s=0;
+        for (std::size_t i=0; i<n; ++i) {
+            if (a[i] && b[i] && c[i]) s+=f(a[i].get(), b[i].get(), c[i].get());
+        }
+        bench::keep(s);
+    });
+
+    bench::run("nested bind", n, [&]() {
+        int s=0;
+        for (std::size_t i=0; i<n; ++i) {
+            const optional<int>& y=b[i];
+            const optional<int>& z=c[i];
+            s+=g(a[i] >> [&](int x) {
+                return y >> [&](int y) {
+                    return z >> [&](int z) { return f(x, y, z); };
+                };
+            });
+        }
+        bench::keep(s);
+    });
+
+    bench::run("hf::apply", n, [&]() {
+        int s=0;
+        for (std::size_t i=0; i<n; ++i) s+=g(hf::apply(f, a[i], b[i], c[i]));
+        bench::keep(s);
+    });
+
+    auto lf=lift(f);
+    bench::run("lift(f)", n, [&]() {
+        int s=0;
+        for (std::size_t i=0; i<n; ++i) s+=g(lf(a[i], b[i], c[i]));
+        bench::keep(s);
+    });
+}
@@ -0,0 +1,71 @@
+// Vector growth and sorting of optional<std::string>, against a wrapper
+// whose move operations may throw and which has no specialised swap,
+// as optional was before they were made conditionally noexcept.
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <optionalm/optional.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+typedef optional<std::string> value;
+
+struct throwing_move {
+    value v;
+
+    throwing_move(value v): v(std::move(v)) {}
+    throwing_move(const throwing_move&)=default;
+    throwing_move(throwing_move&& x) noexcept(false): v(std::move(x.v)) {}
+    throwing_move& operator=(const throwing_move&)=default;
+    throwing_move& operator=(throwing_move&& x) noexcept(false) { v=std::move(x.v); return *this; }
+
+    bool operator<(const throwing_move& x) const { return v<x.v; }
+};
+
+// Distinct strings too long for the small string optimization.
+static std::vector<value> make_values(std::size_t n) {
+    std::vector<value> vs;
+    vs.reserve(n);
+    for (std::size_t i=0; i<n; ++i) {
+        std::size_t k=(i*2654435761u)%n;
+        if (k%10==0) vs.push_back(nothing);
+        else vs.push_back(std::string(40, 'x')+std::to_string(k));
+    }
+    return vs;
+}
+
+template <typename T>
+void time_growth(const char* name, const std::vector<value>& vs) {
+    std::vector<T> v(vs.begin(), vs.end());
+    bench::run_with(name, vs.size(), [&]() { return v; }, [](std::vector<T>& w) {
+        w.reserve(2*w.capacity());
+        bench::keep(w.data());
+    });
+}
+
+template <typename T>
+void time_sort(const char* name, const std::vector<value>& vs) {
+    std::vector<T> v(vs.begin(), vs.end());
+    bench::run_with(name, vs.size(), [&]() { return v; }, [](std::vector<T>& w) {
+        std::sort(w.begin(), w.end());
+        bench::keep(w.data());
+    });
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 200000);
+    std::vector<value> vs=make_values(n);
+
+    bench::heading("vector reallocation, per element");
+    time_growth<value>("optional<string>", vs);
+    time_growth<throwing_move>("wrapper with throwing move", vs);
+
+    bench::heading("std::sort, per element");
+    time_sort<value>("optional<string>", vs);
+    time_sort<throwing_move>("wrapper with throwing move, no swap", vs);
+}
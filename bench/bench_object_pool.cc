@@ -0,0 +1,96 @@
+// Allocating and freeing small objects from several threads with
+// object_pool, through the pool and through per-thread caches, against
+// new and delete and unique_ptr. Each thread keeps a window of live
+// objects, replacing the oldest with a new one at each step.
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <optionalm/object_pool.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+struct record {
+    long key;
+    double values[7];
+
+    explicit record(long k): key(k), values() {}
+};
+
+constexpr std::size_t window=64;
+
+// Run `steps` steps on each of `threads` threads; `body(steps)` is the
+// loop of one thread.
+template <typename Body>
+void concurrent(const char* name, std::size_t steps, unsigned threads, Body body) {
+    bench::run(name, steps*threads, [&]() {
+        std::vector<std::thread> ts;
+        for (unsigned i=0; i<threads; ++i) ts.emplace_back(body, steps);
+        for (auto& t: ts) t.join();
+    }, 3);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 1000000);
+
+    for (unsigned threads: {1u, 4u}) {
+        const std::size_t steps=n/threads;
+        bench::heading(threads==1? "1 thread, per allocation": "4 threads, per allocation");
+
+        concurrent("new and delete", steps, threads, [](std::size_t steps) {
+            record* live[window]={};
+            for (std::size_t k=0; k<steps; ++k) {
+                record*& p=live[k%window];
+                delete p;
+                p=new record(long(k));
+                bench::keep(p);
+            }
+            for (record* p: live) delete p;
+        });
+
+        concurrent("unique_ptr (make_unique equivalent)", steps, threads, [](std::size_t steps) {
+            std::unique_ptr<record> live[window];
+            for (std::size_t k=0; k<steps; ++k) {
+                live[k%window].reset(new record(long(k)));
+                bench::keep(live[k%window].get());
+            }
+        });
+
+        object_pool<record> pool(256);
+
+        concurrent("object_pool acquire and release", steps, threads, [&pool](std::size_t steps) {
+            record* live[window]={};
+            for (std::size_t k=0; k<steps; ++k) {
+                record*& p=live[k%window];
+                if (p) pool.release(*p);
+                p=&pool.acquire(long(k)).get();
+                bench::keep(p);
+            }
+            for (record* p: live) if (p) pool.release(*p);
+        });
+
+        concurrent("object_pool make (handle)", steps, threads, [&pool](std::size_t steps) {
+            object_pool<record>::handle live[window];
+            for (std::size_t k=0; k<steps; ++k) {
+                live[k%window]=pool.make(long(k));
+                bench::keep(live[k%window].get());
+            }
+        });
+
+        concurrent("object_pool::cache acquire and release", steps, threads, [&pool](std::size_t steps) {
+            object_pool<record>::cache cache(pool);
+            record* live[window]={};
+            for (std::size_t k=0; k<steps; ++k) {
+                record*& p=live[k%window];
+                if (p) cache.release(*p);
+                p=&cache.acquire(long(k)).get();
+                bench::keep(p);
+            }
+            for (record* p: live) if (p) cache.release(*p);
+        });
+    }
+}
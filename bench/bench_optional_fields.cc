@@ -0,0 +1,90 @@
+// Size and field scans of records of sixteen optional fields: a tuple of
+// optionals, each with its own flag, against optional_fields. The default
+// number of records fits in cache; larger scales measure memory traffic.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/optional_fields.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+typedef std::tuple<
+    optional<int>, optional<double>, optional<std::int16_t>, optional<std::int64_t>,
+    optional<float>, optional<std::uint8_t>, optional<int>, optional<double>,
+    optional<std::int16_t>, optional<std::int64_t>, optional<float>, optional<std::uint8_t>,
+    optional<int>, optional<double>, optional<std::int16_t>, optional<std::int64_t>> tuple_record;
+
+typedef optional_fields<
+    int, double, std::int16_t, std::int64_t, float, std::uint8_t, int, double,
+    std::int16_t, std::int64_t, float, std::uint8_t, int, double, std::int16_t, std::int64_t> fields_record;
+
+static_assert(std::tuple_size<tuple_record>::value==fields_record::size(), "same fields");
+
+// Number of set fields of a tuple record, field by field.
+template <std::size_t I=0>
+typename std::enable_if<I==std::tuple_size<tuple_record>::value, std::size_t>::type
+count_set(const tuple_record&) { return 0; }
+
+template <std::size_t I=0>
+typename std::enable_if<(I<std::tuple_size<tuple_record>::value), std::size_t>::type
+count_set(const tuple_record& r) { return bool(std::get<I>(r))+count_set<I+1>(r); }
+
+// Set fields I, I+s, I+2s, ... by the bits of `pattern`.
+template <std::size_t I=0>
+typename std::enable_if<I==fields_record::size()>::type
+fill(tuple_record&, fields_record&, unsigned) {}
+
+template <std::size_t I=0>
+typename std::enable_if<(I<fields_record::size())>::type
+fill(tuple_record& t, fields_record& f, unsigned pattern) {
+    if (pattern & (1u<<I)) {
+        typedef typename fields_record::template field_type<I> T;
+        std::get<I>(t)=T(I);
+        f.set<I>(T(I));
+    }
+    fill<I+1>(t, f, pattern);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 10000);
+
+    bench::heading("record of sixteen optional fields");
+    std::printf("  %-40s %10zu bytes\n", "tuple of optionals", sizeof(tuple_record));
+    std::printf("  %-40s %10zu bytes\n", "optional_fields", sizeof(fields_record));
+
+    std::vector<tuple_record> tuples(n);
+    std::vector<fields_record> fields(n);
+    for (std::size_t i=0; i<n; ++i) fill(tuples[i], fields[i], unsigned(i*2654435761u)>>16);
+
+    bench::heading("count set fields, per record");
+    bench::run("tuple of optionals", n, [&]() {
+        std::size_t total=0;
+        for (auto& r: tuples) total+=count_set(r);
+        bench::keep(total);
+    });
+    bench::run("optional_fields::count()", n, [&]() {
+        std::size_t total=0;
+        for (auto& r: fields) total+=r.count();
+        bench::keep(total);
+    });
+
+    bench::heading("records with fields 0, 3 and 7 all set, per record");
+    bench::run("tuple of optionals", n, [&]() {
+        std::size_t total=0;
+        for (auto& r: tuples) total+=std::get<0>(r) && std::get<3>(r) && std::get<7>(r);
+        bench::keep(total);
+    });
+    bench::run("optional_fields::has_all(mask)", n, [&]() {
+        const auto mask=fields_record::bit<0>() | fields_record::bit<3>() | fields_record::bit<7>();
+        std::size_t total=0;
+        for (auto& r: fields) total+=r.has_all(mask);
+        bench::keep(total);
+    });
+}
@@ -0,0 +1,72 @@
+// Memory use and scan speed of tri-state flags held in a
+// packed_optional_vector<bool>, against a std::vector<optional<bool>>.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/packed_optional.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+static optional<bool> flag(std::size_t i, unsigned salt) {
+    unsigned r=unsigned(i*2654435761u+salt)>>20;
+    return r%3==0? optional<bool>(): optional<bool>(r%3==1);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 10000000);
+
+    std::vector<optional<bool>> va, vb;
+    packed_optional_vector<bool> pa, pb;
+    va.reserve(n);
+    vb.reserve(n);
+    for (std::size_t i=0; i<n; ++i) {
+        va.push_back(flag(i, 1));
+        vb.push_back(flag(i, 2));
+        pa.push_back(va.back());
+        pb.push_back(vb.back());
+    }
+
+    bench::heading("memory for the flags");
+    std::printf("  %-40s %10.2f MiB\n", "std::vector<optional<bool>>", n*sizeof(optional<bool>)/1048576.0);
+    std::printf("  %-40s %10.2f MiB\n", "packed_optional_vector<bool>", pa.groups()*packed_optional_vector<bool>::bits*8/1048576.0);
+
+    bench::heading("count set, per element");
+    bench::run("std::vector<optional<bool>>", n, [&]() {
+        std::size_t c=0;
+        for (auto& x: va) c+=bool(x);
+        bench::keep(c);
+    });
+    bench::run("packed_optional_vector<bool>", n, [&]() {
+        bench::keep(pa.count_set());
+    });
+
+    bench::heading("count true, per element");
+    bench::run("std::vector<optional<bool>>", n, [&]() {
+        std::size_t c=0;
+        for (auto& x: va) c+=x && *x;
+        bench::keep(c);
+    });
+    bench::run("packed_optional_vector<bool>", n, [&]() {
+        bench::keep(pa.count(true));
+    });
+
+    bench::heading("Kleene AND of two columns, per element");
+    std::vector<optional<bool>> vr(n);
+    bench::run("std::vector<optional<bool>>", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            const optional<bool>& a=va[i];
+            const optional<bool>& b=vb[i];
+            vr[i]=(a && !*a) || (b && !*b)? optional<bool>(false): a && b? optional<bool>(true): optional<bool>();
+        }
+        bench::keep(vr.data());
+    });
+    bench::run("kleene_and", n, [&]() {
+        bench::keep(kleene_and(pa, pb));
+    });
+}
@@ -0,0 +1,69 @@
+// Throughput of a three-stage pipeline with skewed stage costs, as the
+// number of workers on the costly stage grows, against a plain loop.
+
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include <optionalm/pipeline.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+// Busy work of about `rounds` multiply-adds.
+static std::uint64_t spin(std::uint64_t x, int rounds) {
+    for (int i=0; i<rounds; ++i) x=x*6364136223846793005ull+1442695040888963407ull;
+    return x;
+}
+
+// Cheap: discards one value in four.
+static optional<std::uint64_t> cheap_filter(std::uint64_t x) {
+    if (x%4==0) return nothing;
+    return spin(x, 10);
+}
+
+// Costly: one hundred times the work of the other stages.
+static std::uint64_t costly(std::uint64_t x) {
+    return spin(x, 1000);
+}
+
+static std::uint64_t cheap(std::uint64_t x) {
+    return spin(x, 10)>>1;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 100000);
+    std::vector<std::uint64_t> input(n);
+    for (std::size_t i=0; i<n; ++i) input[i]=i;
+
+    std::vector<std::uint64_t> output;
+    output.reserve(n);
+
+    bench::heading("filter (cheap) -> costly -> cheap, per input value");
+    bench::run("sequential loop", n, [&]() {
+        output.clear();
+        for (auto x: input) {
+            if (auto y=cheap_filter(x)) output.push_back(cheap(costly(*y)));
+        }
+        bench::keep(output.data());
+    }, 3);
+
+    unsigned cores=std::thread::hardware_concurrency();
+    if (!cores) cores=1;
+
+    for (unsigned w=1; w<=2*cores; w*=2) {
+        pipeline_options opt;
+        opt.stage_workers={1, w, 1};
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "pipeline, %u costly-stage workers", w);
+        bench::run(name, n, [&]() {
+            output.clear();
+            run_pipeline(input.begin(), input.end(), std::back_inserter(output), opt, cheap_filter, costly, cheap);
+            bench::keep(output.data());
+        }, 3);
+    }
+}
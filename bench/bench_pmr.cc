@@ -0,0 +1,97 @@
+// Per-request arenas: building a vector of optional strings in a
+// monotonic_buffer_resource, with hf::optional (whose strings use the
+// arena) against std::optional (whose strings use the global heap).
+// Reports heap allocations and time per request.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <optionalm/optional.h>
+
+#if __cplusplus>=201703L
+#include <memory_resource>
+#include <optional>
+#include <vector>
+#endif
+
+#include "bench.h"
+
+#if defined(__cpp_lib_memory_resource)
+
+static std::size_t heap_allocations=0;
+
+void* operator new(std::size_t n) {
+    ++heap_allocations;
+    if (void* p=std::malloc(n? n: 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Used by the default memory resource.
+void* operator new(std::size_t n, std::align_val_t a) {
+    ++heap_allocations;
+    std::size_t align=static_cast<std::size_t>(a);
+    if (void* p=std::aligned_alloc(align, (n+align-1)/align*align)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+constexpr int fields_per_request=64;
+
+// Strings long enough not to fit the small string buffer.
+static const char* text(int i) {
+    return i%2? "a value long enough to need its own allocation": "another value that needs an allocation of its own";
+}
+
+template <template <typename> class Optional>
+void request(std::size_t& sink) {
+    alignas(std::max_align_t) char buffer[16384];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+
+    std::pmr::vector<Optional<std::pmr::string>> fields(&arena);
+    fields.reserve(fields_per_request);
+    for (int i=0; i<fields_per_request; ++i) {
+        if (i%4) fields.emplace_back(text(i));
+        else fields.emplace_back();
+    }
+    sink+=fields.size();
+}
+
+template <typename X> using hf_optional=hf::optional<X>;
+template <typename X> using std_optional=std::optional<X>;
+
+template <template <typename> class Optional>
+void time_requests(const char* name, std::size_t n) {
+    std::size_t sink=0;
+    std::size_t before=heap_allocations;
+    request<Optional>(sink);
+    std::printf("  %-40s %10zu heap allocations per request\n", name, heap_allocations-before);
+
+    bench::run(name, n, [&]() {
+        for (std::size_t i=0; i<n; ++i) request<Optional>(sink);
+        bench::keep(sink);
+    });
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 20000);
+
+    bench::heading("request building 64 optional<pmr::string> fields in an arena");
+    time_requests<hf_optional>("hf::optional", n);
+    time_requests<std_optional>("std::optional", n);
+}
+
+#else
+
+int main() {
+    std::puts("bench_pmr requires C++17 <memory_resource>");
+}
+
+#endif
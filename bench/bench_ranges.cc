@@ -0,0 +1,56 @@
+// Lazy views over sequences of optionals and eithers, against the
+// hand-written loops they replace.
+
+#include <cstddef>
+#include <vector>
+
+#include <optionalm/either.h>
+#include <optionalm/optional.h>
+#include <optionalm/ranges.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 4000000);
+
+    std::vector<optional<double>> opts(n);
+    std::vector<either<int, double>> eithers;
+    eithers.reserve(n);
+    for (std::size_t i=0; i<n; ++i) {
+        unsigned r=unsigned(i*2654435761u)>>8;
+        if (r%4) opts[i]=(r%1000)*0.5;
+        if (r%2) eithers.push_back(either<int, double>(int(r%1000)));
+        else eithers.push_back(either<int, double>(in_place_index_t<1>{}, (r%1000)*0.5));
+    }
+
+    bench::heading("sum of set values of vector<optional<double>>, per element");
+    bench::run("hand-written loop", n, [&]() {
+        double s=0;
+        for (auto& o: opts) if (o) s+=*o;
+        bench::keep(s);
+    });
+    bench::run("for (double x: flatten(v))", n, [&]() {
+        double s=0;
+        for (double x: flatten(opts)) s+=x;
+        bench::keep(s);
+    });
+    bench::run("for (double x: o), o optional", n, [&]() {
+        double s=0;
+        for (auto& o: opts) for (double x: o) s+=x;
+        bench::keep(s);
+    });
+
+    bench::heading("sum of the int fields of vector<either<int, double>>, per element");
+    bench::run("hand-written loop", n, [&]() {
+        long s=0;
+        for (auto& e: eithers) if (e.index()==0) s+=e.unsafe_get<0>();
+        bench::keep(s);
+    });
+    bench::run("for (int x: lefts(v))", n, [&]() {
+        long s=0;
+        for (int x: lefts(eithers)) s+=x;
+        bench::keep(s);
+    });
+}
@@ -0,0 +1,68 @@
+// Reductions over columns of optional<double> and optional<std::int32_t>,
+// one in four unset: the reduce_ kernels against plain loops using
+// operator bool and operator*.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/reduce.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 1000000);
+
+    std::vector<optional<double>> d(n), e(n);
+    std::vector<optional<std::int32_t>> k(n);
+    for (std::size_t i=0; i<n; ++i) {
+        unsigned r=unsigned(i*2654435761u)>>8;
+        if (r%4) d[i]=(r%1000)*0.001;
+        if ((r>>2)%4) e[i]=(r%777)*0.01;
+        if ((r>>4)%4) k[i]=std::int32_t(r%100000)-50000;
+    }
+
+    bench::heading("sum of optional<double>, per element");
+    bench::run("plain loop", n, [&]() {
+        double s=0;
+        for (auto& x: d) if (x) s+=*x;
+        bench::keep(s);
+    });
+    bench::run("reduce_sum", n, [&]() { bench::keep(reduce_sum(d.begin(), d.end())); });
+
+    bench::heading("sum of optional<int32_t>, per element");
+    bench::run("plain loop", n, [&]() {
+        long long s=0;
+        for (auto& x: k) if (x) s+=*x;
+        bench::keep(s);
+    });
+    bench::run("reduce_sum", n, [&]() { bench::keep(reduce_sum(k.begin(), k.end())); });
+
+    bench::heading("count of optional<double>, per element");
+    bench::run("plain loop", n, [&]() {
+        std::size_t c=0;
+        for (auto& x: d) c+=bool(x);
+        bench::keep(c);
+    });
+    bench::run("reduce_count", n, [&]() { bench::keep(reduce_count(d.begin(), d.end())); });
+
+    bench::heading("max of optional<double>, per element");
+    bench::run("plain loop", n, [&]() {
+        optional<double> m;
+        for (auto& x: d) if (x && (!m || *x>*m)) m=*x;
+        bench::keep(m);
+    });
+    bench::run("reduce_max", n, [&]() { bench::keep(reduce_max(d.begin(), d.end())); });
+
+    bench::heading("dot of two optional<double> columns, per element");
+    bench::run("plain loop", n, [&]() {
+        double s=0;
+        for (std::size_t i=0; i<n; ++i) if (d[i] && e[i]) s+=*d[i]**e[i];
+        bench::keep(s);
+    });
+    bench::run("reduce_dot", n, [&]() { bench::keep(reduce_dot(d.begin(), d.end(), e.begin())); });
+}
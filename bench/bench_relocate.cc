@@ -0,0 +1,85 @@
+// Relocating millions of values to a new buffer, as a vector does when
+// it grows: `relocate` (memcpy for trivially relocatable types) against
+// moving and destroying each element.
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <optionalm/either.h>
+#include <optionalm/optional.h>
+#include <optionalm/uninitialized.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+// Move-construct into `dest` and destroy the originals, one at a time.
+template <typename X>
+X* move_and_destroy(X* first, X* last, X* dest) {
+    for (; first!=last; ++first, ++dest) {
+        ::new(static_cast<void*>(dest)) X(std::move(*first));
+        first->~X();
+    }
+    return dest;
+}
+
+// Source buffer of `n` values, and a destination buffer already touched
+// so that page faults are not timed. The values end up in `dest`.
+template <typename X>
+struct buffers {
+    std::size_t n;
+    X* src;
+    X* dest;
+
+    template <typename Make>
+    buffers(std::size_t n, Make make):
+        n(n),
+        src(static_cast<X*>(::operator new(n*sizeof(X)))),
+        dest(static_cast<X*>(::operator new(n*sizeof(X))))
+    {
+        for (std::size_t i=0; i<n; ++i) ::new(static_cast<void*>(src+i)) X(make(i));
+        std::memset(static_cast<void*>(dest), 0, n*sizeof(X));
+    }
+
+    buffers(buffers&& b): n(b.n), src(b.src), dest(b.dest) { b.src=b.dest=nullptr; }
+
+    ~buffers() {
+        if (dest) for (std::size_t i=0; i<n; ++i) dest[i].~X();
+        ::operator delete(src);
+        ::operator delete(dest);
+    }
+};
+
+template <typename X, typename Make>
+void time_relocation(const char* title, std::size_t n, Make make) {
+    auto setup=[&]() { return buffers<X>(n, make); };
+
+    bench::heading(title);
+    bench::run_with("relocate", n, setup, [](buffers<X>& b) {
+        relocate(b.src, b.src+b.n, b.dest);
+    });
+    bench::run_with("move and destroy", n, setup, [](buffers<X>& b) {
+        move_and_destroy(b.src, b.src+b.n, b.dest);
+    });
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 2000000);
+
+    typedef either<std::unique_ptr<int>, int> ptr_either;
+    static_assert(is_trivially_relocatable<ptr_either>::value, "either of unique_ptr is relocatable");
+
+    time_relocation<ptr_either>("either<unique_ptr<int>, int>, per element", n, [](std::size_t i) {
+        return i%2? ptr_either(int(i)): ptr_either(std::unique_ptr<int>());
+    });
+
+    typedef optional<std::unique_ptr<int>> ptr_optional;
+    static_assert(is_trivially_relocatable<ptr_optional>::value, "optional of unique_ptr is relocatable");
+
+    time_relocation<ptr_optional>("optional<unique_ptr<int>>, per element", n, [](std::size_t i) {
+        return i%3? ptr_optional(std::unique_ptr<int>()): ptr_optional();
+    });
+}
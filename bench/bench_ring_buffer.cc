@@ -0,0 +1,133 @@
+// Passing integers between threads through spsc_ring and mpmc_ring,
+// against a bounded queue guarded by a mutex and condition variables:
+// throughput with producers and consumers running flat out, and the
+// round-trip latency of a ping-pong between two threads.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/ring_buffer.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+// Same interface as the rings, but blocking.
+template <typename T>
+class locked_queue {
+    std::deque<T> q_;
+    std::size_t capacity_;
+    std::mutex m_;
+    std::condition_variable not_full_, not_empty_;
+
+public:
+    explicit locked_queue(std::size_t capacity): capacity_(capacity) {}
+
+    void push(T x) {
+        std::unique_lock<std::mutex> lock(m_);
+        not_full_.wait(lock, [&] { return q_.size()<capacity_; });
+        q_.push_back(std::move(x));
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    T pop() {
+        std::unique_lock<std::mutex> lock(m_);
+        not_empty_.wait(lock, [&] { return !q_.empty(); });
+        T x=std::move(q_.front());
+        q_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return x;
+    }
+};
+
+template <typename Ring>
+void ring_push(Ring& q, long x) {
+    while (!q.try_push(x)) std::this_thread::yield();
+}
+
+template <typename Ring>
+long ring_pop(Ring& q) {
+    for (;;) {
+        if (auto x=q.try_pop()) return *x;
+        std::this_thread::yield();
+    }
+}
+
+void push(locked_queue<long>& q, long x) { q.push(x); }
+long pop(locked_queue<long>& q) { return q.pop(); }
+
+template <typename T> void push(spsc_ring<T>& q, long x) { ring_push(q, x); }
+template <typename T> long pop(spsc_ring<T>& q) { return ring_pop(q); }
+template <typename T> void push(mpmc_ring<T>& q, long x) { ring_push(q, x); }
+template <typename T> long pop(mpmc_ring<T>& q) { return ring_pop(q); }
+
+// Each of `producers` threads pushes n/producers values; each of
+// `consumers` threads pops n/consumers.
+template <typename Queue>
+void throughput(const char* name, std::size_t n, unsigned producers, unsigned consumers) {
+    bench::run(name, n, [&]() {
+        Queue q(1024);
+        long total=0;
+        std::mutex total_mutex;
+
+        std::vector<std::thread> threads;
+        for (unsigned i=0; i<consumers; ++i) {
+            threads.emplace_back([&] {
+                long s=0;
+                for (std::size_t k=0; k<n/consumers; ++k) s+=pop(q);
+                std::lock_guard<std::mutex> lock(total_mutex);
+                total+=s;
+            });
+        }
+        for (unsigned i=0; i<producers; ++i) {
+            threads.emplace_back([&] {
+                for (std::size_t k=0; k<n/producers; ++k) push(q, long(k));
+            });
+        }
+        for (auto& t: threads) t.join();
+        bench::keep(total);
+    }, 3);
+}
+
+// One thread sends each value and waits for it to come back on a
+// second queue.
+template <typename Queue>
+void latency(const char* name, std::size_t n) {
+    bench::run(name, n, [&]() {
+        Queue there(16), back(16);
+        std::thread echo([&] {
+            for (std::size_t k=0; k<n; ++k) push(back, pop(there));
+        });
+        long s=0;
+        for (std::size_t k=0; k<n; ++k) {
+            push(there, long(k));
+            s+=pop(back);
+        }
+        echo.join();
+        bench::keep(s);
+    }, 3);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 1000000);
+    const std::size_t m=bench::size(argc, argv, 20000);
+
+    bench::heading("throughput, per element");
+    throughput<spsc_ring<long>>("spsc_ring, 1 producer, 1 consumer", n, 1, 1);
+    throughput<mpmc_ring<long>>("mpmc_ring, 1 producer, 1 consumer", n, 1, 1);
+    throughput<locked_queue<long>>("mutex queue, 1 producer, 1 consumer", n, 1, 1);
+    throughput<mpmc_ring<long>>("mpmc_ring, 4 producers, 4 consumers", n, 4, 4);
+    throughput<locked_queue<long>>("mutex queue, 4 producers, 4 consumers", n, 4, 4);
+
+    bench::heading("ping-pong latency, per round trip");
+    latency<spsc_ring<long>>("spsc_ring", m);
+    latency<mpmc_ring<long>>("mpmc_ring", m);
+    latency<locked_queue<long>>("mutex queue", m);
+}
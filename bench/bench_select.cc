@@ -0,0 +1,46 @@
+// Selecting between optionals holding large payloads: eager `operator|`
+// against lazy `or_else`, and copied against moved operands.
+
+#include <utility>
+#include <vector>
+
+#include <optionalm/optional.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+typedef std::vector<int> payload;
+
+static payload make_fallback() {
+    return payload(1000, 7);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 20000);
+    const optional<payload> set(payload(1000, 1));
+
+    bench::heading("selecting a set optional<vector<int>> of 1000 elements");
+    bench::run("a | optional(make_fallback())", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) bench::keep(set | optional<payload>(make_fallback()));
+    });
+    bench::run("a.or_else(make_fallback)", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) bench::keep(set.or_else(make_fallback));
+    });
+
+    bench::heading("combining a temporary optional<vector<int>>");
+    bench::run("copy: a | b", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            optional<payload> a(set);
+            optional<payload> r=a | optional<payload>();
+            bench::keep(r);
+        }
+    });
+    bench::run("move: std::move(a) | b", n, [&]() {
+        for (std::size_t i=0; i<n; ++i) {
+            optional<payload> a(set);
+            optional<payload> r=std::move(a) | optional<payload>();
+            bench::keep(r);
+        }
+    });
+}
@@ -0,0 +1,48 @@
+// All-or-nothing collection of a vector<optional<string>> with sequence,
+// against the naive loop that pushes values into a vector and discards
+// it at the first unset element, for different failure positions.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/sequence.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+static optional<std::vector<std::string>> naive(const std::vector<optional<std::string>>& v) {
+    std::vector<std::string> out;
+    for (auto& x: v) {
+        if (!x) return nothing;
+        out.push_back(*x);
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 100000);
+
+    std::vector<optional<std::string>> v(n, std::string("a string longer than the small buffer"));
+
+    // Failure at the given fraction of the way through; 1 means none.
+    const double positions[]={0.0, 0.1, 0.5, 0.9, 1.0};
+    for (double at: positions) {
+        std::size_t k=std::size_t(at*n);
+        optional<std::string> saved;
+        if (k<n) std::swap(saved, v[k]);
+
+        char title[80];
+        if (k<n) std::snprintf(title, sizeof(title), "first unset element at %.0f%%, per element", at*100);
+        else std::snprintf(title, sizeof(title), "no unset element, per element");
+        bench::heading(title);
+
+        bench::run("naive loop", n, [&]() { bench::keep(naive(v)); });
+        bench::run("sequence(v)", n, [&]() { bench::keep(sequence(v)); });
+
+        if (k<n) std::swap(saved, v[k]);
+    }
+}
@@ -0,0 +1,116 @@
+// Read scaling of a shared optional value, from 1 to 64 reader threads,
+// with a writer updating it every 100 us: seqlock_optional and
+// rcu_optional against an optional guarded by a shared mutex. Reports
+// the aggregate time per read (wall time over total reads).
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __cplusplus>=201402L
+#include <shared_mutex>
+#endif
+
+#include <optionalm/optional.h>
+#include <optionalm/shared_optional.h>
+
+#include "bench.h"
+
+using namespace hf;
+
+struct config {
+    long version;
+    double threshold;
+};
+
+#if __cplusplus>=201402L
+typedef std::shared_timed_mutex reader_writer_mutex;
+template <typename M> using read_lock=std::shared_lock<M>;
+#else
+typedef std::mutex reader_writer_mutex;
+template <typename M> using read_lock=std::lock_guard<M>;
+#endif
+
+struct locked_optional {
+    mutable reader_writer_mutex mutex;
+    optional<config> value;
+
+    optional<config> load() const {
+        read_lock<reader_writer_mutex> lock(mutex);
+        return value;
+    }
+
+    void store(const optional<config>& x) {
+        std::lock_guard<reader_writer_mutex> lock(mutex);
+        value=x;
+    }
+};
+
+// Run `threads` readers calling `read()` and one writer calling
+// `write(k)` every 100 us for `duration`, and report per read.
+template <typename Read, typename Write>
+void time_reads(const char* name, unsigned threads, std::chrono::milliseconds duration, Read read, Write write) {
+    std::atomic<bool> start(false), stop(false);
+    std::atomic<long> total(0);
+
+    std::vector<std::thread> readers;
+    for (unsigned t=0; t<threads; ++t) {
+        readers.emplace_back([&]() {
+            while (!start) std::this_thread::yield();
+            long reads=0;
+            double sum=0;
+            while (!stop) {
+                for (int i=0; i<64; ++i, ++reads) sum+=read();
+            }
+            bench::keep(sum);
+            total+=reads;
+        });
+    }
+
+    std::thread writer([&]() {
+        while (!start) std::this_thread::yield();
+        for (long k=0; !stop; ++k) {
+            write(k);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    auto t0=std::chrono::steady_clock::now();
+    start=true;
+    std::this_thread::sleep_for(duration);
+    stop=true;
+    for (auto& t: readers) t.join();
+    writer.join();
+    double elapsed=std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now()-t0).count();
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s, %u readers", name, threads);
+    bench::report(label, total.load(), elapsed);
+}
+
+int main(int argc, char** argv) {
+    const std::chrono::milliseconds duration(bench::size(argc, argv, 100));
+
+    seqlock_optional<config> seq(config{0, 0.5});
+    rcu_optional<std::string> rcu{std::string("threshold=0.5")};
+    locked_optional locked;
+    locked.store(config{0, 0.5});
+
+    bench::heading("reads with a concurrent writer, aggregate per read");
+    for (unsigned threads=1; threads<=64; threads*=4) {
+        time_reads("seqlock_optional", threads, duration,
+            [&]() { return seq.load()->threshold; },
+            [&](long k) { seq.store(config{k, 0.5}); });
+        time_reads("rcu_optional", threads, duration,
+            [&]() { return rcu.read([](const optional<std::string>& s) { return double(s->size()); }); },
+            [&](long k) { rcu.store(std::string("threshold=0.5;v=")+std::to_string(k)); });
+        time_reads("shared mutex", threads, duration,
+            [&]() { return locked.load()->threshold; },
+            [&](long k) { locked.store(config{k, 0.5}); });
+    }
+}
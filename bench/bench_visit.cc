@@ -0,0 +1,105 @@
+// Dispatch on a random mix of alternatives: hf::visit and match on
+// either, against switching on the index by hand and, from C++17,
+// std::visit on the equivalent std::variant.
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <optionalm/either.h>
+
+#if __cplusplus>=201703L
+#include <variant>
+#endif
+
+#include "bench.h"
+
+using namespace hf;
+
+typedef either<int, double> value;
+
+struct weigh {
+    double operator()(int x) const { return 3*x; }
+    double operator()(double x) const { return x*0.5; }
+};
+
+struct weigh_pair {
+    double operator()(int x, int y) const { return x-y; }
+    double operator()(int x, double y) const { return x*y; }
+    double operator()(double x, int y) const { return x+y; }
+    double operator()(double x, double y) const { return x/y; }
+};
+
+int main(int argc, char** argv) {
+    const std::size_t n=bench::size(argc, argv, 4000000);
+
+    std::minstd_rand rng(7);
+    std::bernoulli_distribution coin(0.5);
+
+    std::vector<value> vs;
+    vs.reserve(n);
+    for (std::size_t i=0; i<n; ++i) {
+        if (coin(rng)) vs.push_back(value(int(i%100)));
+        else vs.push_back(value(in_place_index_t<1>{}, 1.0+i%100));
+    }
+
+    bench::heading("unary dispatch, per element");
+    bench::run("switch on index()", n, [&]() {
+        double sum=0;
+        for (auto& v: vs) {
+            switch (v.index()) {
+            case 0: sum+=weigh()(v.unsafe_get<0>()); break;
+            case 1: sum+=weigh()(v.unsafe_get<1>()); break;
+            }
+        }
+        bench::keep(sum);
+    });
+    bench::run("visit(f, e)", n, [&]() {
+        double sum=0;
+        for (auto& v: vs) sum+=visit(weigh(), v);
+        bench::keep(sum);
+    });
+    bench::run("e.match(f0, f1)", n, [&]() {
+        double sum=0;
+        for (auto& v: vs) sum+=v.match([](int x) { return 3.0*x; }, [](double x) { return x*0.5; });
+        bench::keep(sum);
+    });
+
+    bench::heading("binary dispatch, per pair");
+    bench::run("nested switch on index()", n-1, [&]() {
+        double sum=0;
+        for (std::size_t i=0; i+1<n; ++i) {
+            const value& a=vs[i];
+            const value& b=vs[i+1];
+            if (a.index()==0) sum+=b.index()==0? weigh_pair()(a.unsafe_get<0>(), b.unsafe_get<0>()): weigh_pair()(a.unsafe_get<0>(), b.unsafe_get<1>());
+            else sum+=b.index()==0? weigh_pair()(a.unsafe_get<1>(), b.unsafe_get<0>()): weigh_pair()(a.unsafe_get<1>(), b.unsafe_get<1>());
+        }
+        bench::keep(sum);
+    });
+    bench::run("visit(f, a, b)", n-1, [&]() {
+        double sum=0;
+        for (std::size_t i=0; i+1<n; ++i) sum+=visit(weigh_pair(), vs[i], vs[i+1]);
+        bench::keep(sum);
+    });
+
+#if __cplusplus>=201703L
+    std::vector<std::variant<int, double>> svs;
+    svs.reserve(n);
+    for (auto& v: vs) {
+        if (v.index()==0) svs.emplace_back(v.unsafe_get<0>());
+        else svs.emplace_back(v.unsafe_get<1>());
+    }
+
+    bench::heading("std::visit on std::variant<int, double>");
+    bench::run("unary, per element", n, [&]() {
+        double sum=0;
+        for (auto& v: svs) sum+=std::visit(weigh(), v);
+        bench::keep(sum);
+    });
+    bench::run("binary, per pair", n-1, [&]() {
+        double sum=0;
+        for (std::size_t i=0; i+1<n; ++i) sum+=std::visit(weigh_pair(), svs[i], svs[i+1]);
+        bench::keep(sum);
+    });
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef HF_BITS_H_
+#define HF_BITS_H_
+
+/* Low-level helpers shared by several optionalm headers.
+ *
+ * `detail::popcount` counts the set bits in a 64-bit word, using the
+ * compiler builtin where available. `detail::cache_line_size` is the
+ * size assumed for padding and aligning data touched by different
+ * threads.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hf {
+
+namespace detail {
+    constexpr std::size_t cache_line_size=64;
+
+    inline unsigned popcount(std::uint64_t x) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(x);
+#else
+        unsigned n=0;
+        for (; x; x&=x-1) ++n;
+        return n;
+#endif
+    }
+} // namespace detail
+
+} // namespace hf
+
+#endif // ndef HF_BITS_H_
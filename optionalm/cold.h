@@ -0,0 +1,204 @@
+#ifndef HF_COLD_H_
+#define HF_COLD_H_
+
+/* Out-of-line storage for rarely used values.
+ *
+ * `cold<E>` holds a value of type `E` in a separately allocated block,
+ * and is itself a single pointer. Used as the error field of an
+ * `either<T, cold<E>>`, it keeps the size of the `either` close to that
+ * of `T` and its tag however large `E` is, while constructing,
+ * returning or destroying a value holding a `T` never allocates.
+ *
+ * `cold<E>` is implicitly constructible from an `E`, so that an error
+ * may be returned as is, and is copied by copying the value; moving it
+ * transfers the block, leaving the source empty. The value is reached
+ * with `*`, `->` or `get()`; comparisons compare values.
+ *
+ * Blocks are taken from a free list local to the thread, one for each
+ * block size, which holds up to `cold_cache_limit` blocks; any further
+ * blocks are returned to the global allocator. A block released on
+ * another thread joins that thread's list. The lists are emptied at
+ * thread exit. `E` may not be over-aligned.
+ */
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/uninitialized.h>
+
+namespace hf {
+
+constexpr std::size_t cold_cache_limit=64;
+
+namespace detail {
+    struct cold_block {
+        cold_block* next;
+    };
+
+    // Trivially destructible, so that it remains usable during thread
+    // exit, after `cold_pool::drain` has emptied it.
+    struct cold_list {
+        cold_block* head;
+        std::size_t size;
+        bool closed;
+    };
+
+    constexpr std::size_t cold_block_size(std::size_t n) {
+        return n<sizeof(cold_block)? sizeof(cold_block):
+            (n+alignof(std::max_align_t)-1)/alignof(std::max_align_t)*alignof(std::max_align_t);
+    }
+
+    template <std::size_t Size>
+    struct cold_pool {
+        static cold_list& local() {
+            static thread_local cold_list list={nullptr, 0, false};
+            return list;
+        }
+
+        struct drain {
+            ~drain() {
+                cold_list& list=local();
+                list.closed=true;
+                while (cold_block* b=list.head) {
+                    list.head=b->next;
+                    ::operator delete(b);
+                }
+                list.size=0;
+            }
+        };
+
+        static void* allocate() {
+            cold_list& list=local();
+            if (cold_block* b=list.head) {
+                list.head=b->next;
+                --list.size;
+                return b;
+            }
+            return ::operator new(Size);
+        }
+
+        static void deallocate(void* p) noexcept {
+            cold_list& list=local();
+            if (list.closed || list.size==cold_cache_limit) {
+                ::operator delete(p);
+                return;
+            }
+
+            // Constructed with the first cached block; drains the list at thread exit.
+            static thread_local drain on_exit;
+            (void)on_exit;
+
+            cold_block* b=::new(p) cold_block;
+            b->next=list.head;
+            list.head=b;
+            ++list.size;
+        }
+    };
+} // namespace detail
+
+template <typename E>
+class cold {
+    static_assert(alignof(E)<=alignof(std::max_align_t), "cold does not support over-aligned types");
+    static_assert(!std::is_reference<E>::value && !std::is_void<E>::value, "cold requires an object type");
+
+    typedef detail::cold_pool<detail::cold_block_size(sizeof(E))> pool;
+
+    E* p_;
+
+    template <typename... Args>
+    static E* make(Args&&... args) {
+        void* block=pool::allocate();
+        try {
+            return ::new(block) E(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            pool::deallocate(block);
+            throw;
+        }
+    }
+
+    void clear() noexcept {
+        if (p_) {
+            p_->~E();
+            pool::deallocate(p_);
+            p_=nullptr;
+        }
+    }
+
+public:
+    typedef E value_type;
+
+    template <typename... Args>
+    explicit cold(in_place_t, Args&&... args): p_(make(std::forward<Args>(args)...)) {}
+
+    cold(const E& x): p_(make(x)) {}
+    cold(E&& x): p_(make(std::move(x))) {}
+
+    cold(const cold& x): p_(x.p_? make(*x.p_): nullptr) {}
+    cold(cold&& x) noexcept: p_(x.p_) { x.p_=nullptr; }
+
+    cold& operator=(const cold& x) {
+        if (this!=&x) {
+            cold tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    cold& operator=(cold&& x) noexcept {
+        if (this!=&x) {
+            clear();
+            p_=x.p_;
+            x.p_=nullptr;
+        }
+        return *this;
+    }
+
+    ~cold() { clear(); }
+
+    void swap(cold& x) noexcept { std::swap(p_, x.p_); }
+
+    // True only for a moved-from value.
+    bool empty() const noexcept { return !p_; }
+
+    E& get() { return *p_; }
+    const E& get() const { return *p_; }
+
+    E& operator*() { return *p_; }
+    const E& operator*() const { return *p_; }
+
+    E* operator->() { return p_; }
+    const E* operator->() const { return p_; }
+};
+
+template <typename E>
+void swap(cold<E>& a, cold<E>& b) noexcept { a.swap(b); }
+
+template <typename E>
+bool operator==(const cold<E>& a, const cold<E>& b) { return *a==*b; }
+
+template <typename E>
+bool operator!=(const cold<E>& a, const cold<E>& b) { return *a!=*b; }
+
+template <typename E>
+bool operator<(const cold<E>& a, const cold<E>& b) { return *a<*b; }
+
+template <typename E>
+bool operator<=(const cold<E>& a, const cold<E>& b) { return *a<=*b; }
+
+template <typename E>
+bool operator>(const cold<E>& a, const cold<E>& b) { return *a>*b; }
+
+template <typename E>
+bool operator>=(const cold<E>& a, const cold<E>& b) { return *a>=*b; }
+
+// The moved-from value is empty, so that relocation by copying the
+// pointer is equivalent to move and destroy.
+template <typename E>
+struct is_trivially_relocatable<cold<E>>: std::true_type {};
+
+} // namespace hf
+
+#endif // ndef HF_COLD_H_
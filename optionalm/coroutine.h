@@ -0,0 +1,142 @@
+#ifndef HF_COROUTINE_H_
+#define HF_COROUTINE_H_
+
+/* Coroutine support for `optional` and `either` (requires C++20).
+ *
+ * A coroutine returning `optional<T>` may `co_await` an optional
+ * value: if it is set, the expression yields the contained value;
+ * if unset, the coroutine is abandoned and returns an unset
+ * `optional<T>`.
+ *
+ *     optional<double> ratio(int key) {
+ *         int a = co_await lookup(key);
+ *         int b = co_await lookup(key+1);
+ *         co_return b? optional<double>(a/(double)b): nothing;
+ *     }
+ *
+ * Similarly, a coroutine returning `either<T, E>` may `co_await` an
+ * `either<U, F>` with `F` convertible to `E`: the first field is
+ * yielded, or the second field is returned as the coroutine's result.
+ *
+ * Coroutines never suspend: they run to completion or are destroyed
+ * at the first short-circuiting `co_await`, before returning to the
+ * caller. The coroutine frame therefore never outlives the call,
+ * which lets the compiler elide its heap allocation.
+ *
+ * `get_return_object()` returns the declared return type itself,
+ * constructed unset (or valueless) with its address recorded in the
+ * promise, which writes the result there. This does not depend on
+ * whether the returned object is initialized before the coroutine body
+ * runs or moved from a temporary after the body completes.
+ */
+
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/optional.h>
+#include <optionalm/either.h>
+
+namespace hf {
+
+namespace detail {
+    // The coroutine result is the object returned by `get_return_object`,
+    // found through `result.target`.
+    template <typename R>
+    struct coroutine_promise_base {
+        result_slot<R> result;
+
+        R get_return_object() noexcept { return R(result); }
+
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+
+        template <typename U>
+        void return_value(U&& u) { *result.target=R(std::forward<U>(u)); }
+
+        // Exceptions propagate directly to the caller.
+        void unhandled_exception() { throw; }
+    };
+
+    // Awaiter over a (forwarding) reference `O&&` to an optional or
+    // either operand; `await_resume` yields the wrapped value as an
+    // lvalue or rvalue according to the operand.
+    template <typename O, typename Reference, typename Value>
+    struct coroutine_awaiter_base {
+        O&& operand;
+
+        typedef typename std::conditional<
+            std::is_lvalue_reference<O>::value || std::is_reference<Value>::value,
+            Reference,
+            typename std::remove_reference<Reference>::type&&
+        >::type result_type;
+    };
+
+    template <typename O, typename base=coroutine_awaiter_base<O, decltype(*std::declval<O&>()), typename wrapped_type<O>::type>>
+    struct optional_awaiter: base {
+        using typename base::result_type;
+        using base::operand;
+
+        bool await_ready() const noexcept { return (bool)operand; }
+
+        // The result is left unset.
+        template <typename P>
+        void await_suspend(std::coroutine_handle<P> h) {
+            h.destroy();
+        }
+
+        result_type await_resume() { return static_cast<result_type>(*operand); }
+    };
+
+    template <typename E> struct either_first;
+    template <typename A, typename B> struct either_first<either<A, B>> { typedef A type; };
+
+    template <typename O, typename base=coroutine_awaiter_base<O,
+        decltype(std::declval<O&>().template unsafe_get<0>()),
+        typename either_first<typename std::decay<O>::type>::type>>
+    struct either_awaiter: base {
+        using typename base::result_type;
+        using base::operand;
+
+        bool await_ready() const noexcept { return operand.index()==0; }
+
+        template <typename P>
+        void await_suspend(std::coroutine_handle<P> h) {
+            typedef typename std::decay<decltype(*h.promise().result.target)>::type R;
+            *h.promise().result.target=R(in_place_index_t<1>{}, either_forward<1>(std::forward<O>(operand)));
+            h.destroy();
+        }
+
+        result_type await_resume() { return static_cast<result_type>(operand.template unsafe_get<0>()); }
+    };
+
+    template <typename T>
+    struct optional_promise: coroutine_promise_base<optional<T>> {
+        template <typename O, typename =typename std::enable_if<is_optional<O>::value>::type>
+        optional_awaiter<O> await_transform(O&& o) noexcept { return {std::forward<O>(o)}; }
+    };
+
+    template <typename A, typename B>
+    struct either_promise: coroutine_promise_base<either<A, B>> {
+        template <typename O, typename =typename std::enable_if<is_either<O>::value>::type>
+        either_awaiter<O> await_transform(O&& o) noexcept { return {std::forward<O>(o)}; }
+    };
+} // namespace detail
+
+} // namespace hf
+
+template <typename T, typename... Args>
+struct std::coroutine_traits<hf::optional<T>, Args...> {
+    using promise_type=hf::detail::optional_promise<T>;
+};
+
+template <typename A, typename B, typename... Args>
+struct std::coroutine_traits<hf::either<A, B>, Args...> {
+    using promise_type=hf::detail::either_promise<A, B>;
+};
+
+#endif // defined(__cpp_impl_coroutine)
+
+#endif // ndef HF_COROUTINE_H_
@@ -1,6 +1,8 @@
 #ifndef HF_EITHER_H_
 #define HF_EITHER_H_
 
+#include <cstdint>
+#include <memory>
 #include <type_traits>
 #include <string>
 #include <stdexcept>
@@ -14,20 +16,84 @@ struct bad_either_access: public std::runtime_error {
     bad_either_access(): bad_either_access("get on unset either field") {}
 };
 
+// Number of low-order bits that are always zero in a pointer to `X`.
+// When both alternatives of an `either` are references to types with
+// a spare bit, the discriminant is stored in the low bit of the
+// pointer. Specialize for types that are incomplete where the either
+// is used, or to disable packing by declaring zero bits.
+template <typename X>
+struct pointer_tag_bits:
+    std::integral_constant<unsigned, (alignof(X)>=2) + (alignof(X)>=4) + (alignof(X)>=8)> {};
+
 namespace detail {
-    template <typename A,typename B>
+    template <typename A, typename B>
+    struct either_packed: std::false_type {};
+
+    template <typename A, typename B>
+    struct either_packed<A&, B&>: std::integral_constant<bool,
+        (pointer_tag_bits<A>::value>0 && pointer_tag_bits<B>::value>0)> {};
+
+    // Storage for the fields of an `either` and the index of the
+    // occupied field, or `either_npos` if neither is.
+    template <typename A, typename B, bool packed=either_packed<A, B>::value>
     struct either_data {
         union {
             uninitialized<A> ua;
             uninitialized<B> ub;
         };
+        signed char which;
+
+        static constexpr signed char either_npos=-1;
+    };
+
+    // Reference field of a packed either: a pointer with the field index
+    // in its low bit; presents the same interface as `uninitialized<X&>`.
+    template <typename X, unsigned I>
+    struct tagged_ref {
+        std::uintptr_t word;
+
+        typedef X *pointer;
+        typedef const X *const_pointer;
+        typedef X &reference;
+        typedef const X &const_reference;
+
+        pointer ptr() { return reinterpret_cast<X*>(word & ~std::uintptr_t(1)); }
+        const_pointer cptr() const { return reinterpret_cast<const X*>(word & ~std::uintptr_t(1)); }
+
+        reference ref() { return *ptr(); }
+        const_reference cref() const { return *cptr(); }
+
+        void construct(X& x) { word=reinterpret_cast<std::uintptr_t>(&x) | I; }
+        template <typename Alloc>
+        void construct_using_allocator(const Alloc&, X& x) { construct(x); }
+        void assign(const X& x) { construct(const_cast<X&>(x)); }
+        void destruct() {}
+        void swap(tagged_ref& u) noexcept { std::swap(word, u.word); }
+
+        template <typename F>
+        typename std::result_of<F(reference)>::type apply(F&& f) { return f(ref()); }
+        template <typename F>
+        typename std::result_of<F(const_reference)>::type apply(F&& f) const { return f(cref()); }
+    };
+
+    // Discriminant of a packed either, read from the low bit of the
+    // occupied field; it is set when a field is constructed.
+    struct tagged_index {
+        std::uintptr_t word;
+
+        operator signed char() const { return word & 1; }
+        tagged_index& operator=(signed char) { return *this; }
+    };
 
-        either_data()=default;
+    template <typename A, typename B>
+    struct either_data<A&, B&, true> {
+        union {
+            tagged_ref<A, 0> ua;
+            tagged_ref<B, 1> ub;
+            tagged_index which;
+        };
 
-        either_data(const either_data&)=delete;
-        either_data(either_data&&)=delete;
-        either_data& operator=(const either_data&)=delete;
-        either_data& operator=(either_data&&)=delete;
+        static constexpr signed char either_npos=-1;
     };
 
     template <std::size_t, typename A, typename B>
@@ -35,14 +101,14 @@ namespace detail {
 
     template <typename A, typename B>
     struct either_select<0, A, B> {
-        typedef uninitialized<A> type;
+        typedef decltype(std::declval<either_data<A, B>&>().ua) type;
         static type& field(either_data<A, B>& u) { return u.ua; }
         static const type& field(const either_data<A, B>& u) { return u.ua; }
     };
 
     template <typename A,typename B>
     struct either_select<1, A, B> {
-        typedef uninitialized<B> type;
+        typedef decltype(std::declval<either_data<A, B>&>().ub) type;
         static type& field(either_data<A, B> &u) { return u.ub; }
         static const type& field(const either_data<A, B> &u) { return u.ub; }
     };
@@ -96,38 +162,295 @@ namespace detail {
         static X& move(X& x) { return x; }
     };
 
-    struct ctor_tag {};
+    // Fields that are references or trivially copyable types can
+    // be copied, moved and destroyed trivially.
+    template <typename X>
+    struct either_trivial: std::integral_constant<bool,
+        std::is_reference<X>::value || std::is_trivially_copyable<X>::value> {};
+
+    template <typename X>
+    struct either_nothrow_move: std::integral_constant<bool,
+        std::is_reference<X>::value || std::is_nothrow_move_constructible<X>::value> {};
+
+    template <typename X>
+    struct either_nothrow_copy: std::integral_constant<bool,
+        std::is_reference<X>::value || std::is_nothrow_copy_constructible<X>::value> {};
+
+    // Copy, move and destruction of an `either`; if both fields are
+    // trivial, these are the implicitly defined (trivial) operations.
+    template <typename A, typename B, bool trivial=either_trivial<A>::value && either_trivial<B>::value>
+    struct either_base: either_data<A, B> {};
+
+    template <typename A, typename B>
+    struct either_base<A, B, false>: either_data<A, B> {
+        using either_data<A, B>::which;
+        using either_data<A, B>::either_npos;
+
+        either_base()=default;
+
+        // Copy constructor.
+        either_base(const either_base& x)
+            noexcept(std::is_nothrow_copy_constructible<A>::value && std::is_nothrow_copy_constructible<B>::value)
+        {
+            which=x.which;
+            switch (which) {
+            case 0:
+                field<0>().construct(x.field<0>().cref());
+                break;
+            case 1:
+                field<1>().construct(x.field<1>().cref());
+                break;
+            }
+        }
+
+        // Move constructor.
+        either_base(either_base&& x)
+            noexcept(std::is_nothrow_move_constructible<A>::value && std::is_nothrow_move_constructible<B>::value)
+        {
+            which=x.which;
+            switch (which) {
+            case 0:
+                field<0>().construct(ref_adaptor<A>::move(x.field<0>().ref()));
+                break;
+            case 1:
+                field<1>().construct(ref_adaptor<B>::move(x.field<1>().ref()));
+                break;
+            }
+        }
+
+        // Copy assignment.
+        either_base& operator=(const either_base& x)
+            noexcept(
+                std::is_nothrow_copy_constructible<A>::value && std::is_nothrow_copy_assignable<A>::value &&
+                std::is_nothrow_copy_constructible<B>::value && std::is_nothrow_copy_assignable<B>::value)
+        {
+            if (which==0) {
+                if (x.which==0) {
+                    field<0>().assign(x.field<0>().cref());
+                }
+                else if (x.which==1) {
+                    auto b_tmp = ref_adaptor<B>::from_ref(x.field<1>().cref());
+                    field<0>().destruct();
+                    if (!either_nothrow_move<B>::value) which=either_npos;
+                    field<1>().construct(ref_adaptor<B>::to_ref(std::move(b_tmp)));
+                    which=1;
+                }
+                else {
+                    field<0>().destruct();
+                    which=either_npos;
+                }
+            }
+            else if (which==1) {
+                if (x.which==0) {
+                    auto a_tmp = ref_adaptor<A>::from_ref(x.field<0>().cref());
+                    field<1>().destruct();
+                    if (!either_nothrow_move<A>::value) which=either_npos;
+                    field<0>().construct(ref_adaptor<A>::to_ref(std::move(a_tmp)));
+                    which=0;
+                }
+                else if (x.which==1) {
+                    field<1>().assign(x.field<1>().cref());
+                }
+                else {
+                    field<1>().destruct();
+                    which=either_npos;
+                }
+            }
+            else {
+                if (x.which==0) {
+                    field<0>().construct(x.field<0>().cref());
+                    which=0;
+                }
+                else if (x.which==1) {
+                    field<1>().construct(x.field<1>().cref());
+                    which=1;
+                }
+            }
+            return *this;
+        }
+
+        // Move assignment.
+        either_base& operator=(either_base&& x)
+            noexcept(
+                std::is_nothrow_move_constructible<A>::value && std::is_nothrow_move_assignable<A>::value &&
+                std::is_nothrow_move_constructible<B>::value && std::is_nothrow_move_assignable<B>::value)
+        {
+            if (which==0) {
+                if (x.which==0) {
+                    field<0>().assign(std::move(x.field<0>().ref()));
+                }
+                else if (x.which==1) {
+                    if (!either_nothrow_move<B>::value) which=either_npos;
+                    field<0>().destruct();
+                    field<1>().construct(ref_adaptor<B>::move(x.field<1>().ref()));
+                    which=1;
+                }
+                else {
+                    which=either_npos;
+                    field<0>().destruct();
+                }
+            }
+            else if (which==1) {
+                if (x.which==0) {
+                    if (!either_nothrow_move<A>::value) which=either_npos;
+                    field<1>().destruct();
+                    field<0>().construct(ref_adaptor<A>::move(x.field<0>().ref()));
+                    which=0;
+                }
+                else if (x.which==1) {
+                    field<1>().assign(std::move(x.field<1>().ref()));
+                }
+                else {
+                    which=either_npos;
+                    field<1>().destruct();
+                }
+            }
+            else {
+                if (x.which==0) {
+                    field<0>().construct(ref_adaptor<A>::move(x.field<0>().ref()));
+                    which=0;
+                }
+                else if (x.which==1) {
+                    field<1>().construct(ref_adaptor<B>::move(x.field<1>().ref()));
+                    which=1;
+                }
+            }
+            return *this;
+        }
+
+        // Destruction.
+        ~either_base() {
+            switch (which) {
+            case 0:
+                field<0>().destruct();
+                break;
+            case 1:
+                field<1>().destruct();
+                break;
+            }
+        }
+
+    private:
+        template <std::size_t I>
+        typename either_select<I, A, B>::type& field() { return either_select<I, A, B>::field(*this); }
+
+        template <std::size_t I>
+        const typename either_select<I, A, B>::type& field() const { return either_select<I, A, B>::field(*this); }
+    };
 } // namespace detail
 
-template <std::size_t I>
-struct in_place_index_t: detail::ctor_tag {};
+template <typename A, typename B>
+class either;
+
+namespace detail {
+    template <typename X> struct is_either_: std::false_type {};
+    template <typename A, typename B> struct is_either_<either<A, B>>: std::true_type {};
+
+    template <typename X>
+    struct is_either: is_either_<typename std::decay<X>::type> {};
+
+    // Field `I` of an either, moved from if the either is an rvalue.
+    template <std::size_t I, typename A, typename B>
+    typename either_get<I, A, B>::type::reference either_forward(either<A, B>& e) {
+        return e.template unsafe_get<I>();
+    }
+
+    template <std::size_t I, typename A, typename B>
+    typename either_get<I, A, B>::type::const_reference either_forward(const either<A, B>& e) {
+        return e.template unsafe_get<I>();
+    }
+
+    template <
+        std::size_t I, typename A, typename B,
+        typename R=typename std::add_rvalue_reference<typename std::conditional<I==0, A, B>::type>::type
+    >
+    R either_forward(either<A, B>&& e) {
+        return static_cast<R>(e.template unsafe_get<I>());
+    }
+
+    template <std::size_t I, typename E>
+    struct either_field_ref {
+        typedef decltype(either_forward<I>(std::declval<E>())) type;
+    };
+
+    template <typename F, std::size_t I, typename E>
+    using either_call_t = decltype(std::declval<F&>()(std::declval<typename either_field_ref<I, E>::type>()));
+
+    template <typename E, typename F0, typename F1>
+    using either_match_t = typename std::common_type<either_call_t<F0, 0, E>, either_call_t<F1, 1, E>>::type;
+
+    template <typename R, typename E, typename F0, typename F1>
+    R either_match(E&& e, F0& f0, F1& f1) {
+        switch (e.index()) {
+        case 0:
+            return static_cast<R>(f0(either_forward<0>(std::forward<E>(e))));
+        case 1:
+            return static_cast<R>(f1(either_forward<1>(std::forward<E>(e))));
+        default:
+            throw bad_either_access("visit of valueless either");
+        }
+    }
+
+    template <typename F, std::size_t I, typename E1, std::size_t J, typename E2>
+    using either_call2_t = decltype(std::declval<F&>()(
+        std::declval<typename either_field_ref<I, E1>::type>(),
+        std::declval<typename either_field_ref<J, E2>::type>()));
+
+    template <typename F, typename E1, typename E2>
+    using either_visit_t = typename std::common_type<
+        either_call2_t<F, 0, E1, 0, E2>, either_call2_t<F, 0, E1, 1, E2>,
+        either_call2_t<F, 1, E1, 0, E2>, either_call2_t<F, 1, E1, 1, E2>>::type;
+
+    // Dispatch on the pair of field indices through a table of the
+    // four instantiations.
+    template <typename R, typename F, typename E1, typename E2>
+    struct either_visit_table {
+        template <std::size_t I, std::size_t J>
+        static R call(F& f, E1&& a, E2&& b) {
+            return static_cast<R>(f(either_forward<I>(std::forward<E1>(a)), either_forward<J>(std::forward<E2>(b))));
+        }
+
+        static R visit(F& f, E1&& a, E2&& b) {
+            static R (* const table[4])(F&, E1&&, E2&&) = {
+                &call<0, 0>, &call<0, 1>, &call<1, 0>, &call<1, 1>
+            };
 
-#if defined(__cpp_variable_templates)
-template <std::size_t I> constexpr in_place_index_t<I> in_place_index{};
-#endif
+            std::size_t i=a.index(), j=b.index();
+            if (i>1 || j>1) throw bad_either_access("visit of valueless either");
+            return table[2*i+j](f, std::forward<E1>(a), std::forward<E2>(b));
+        }
+    };
 
-struct in_place_t: detail::ctor_tag {};
-constexpr in_place_t in_place{};
+    // Generic operators for field comparisons.
+    struct either_eq { template <typename X> bool operator()(const X& a, const X& b) const { return a==b; } };
+    struct either_ne { template <typename X> bool operator()(const X& a, const X& b) const { return a!=b; } };
+    struct either_lt { template <typename X> bool operator()(const X& a, const X& b) const { return a<b; } };
+    struct either_le { template <typename X> bool operator()(const X& a, const X& b) const { return a<=b; } };
+    struct either_gt { template <typename X> bool operator()(const X& a, const X& b) const { return a>b; } };
+    struct either_ge { template <typename X> bool operator()(const X& a, const X& b) const { return a>=b; } };
+} // namespace detail
 
 template <typename A,typename B>
-class either: public detail::either_data<A, B> {
-    using base=detail::either_data<A, B>;
+class either: public detail::either_base<A, B> {
+    using base=detail::either_base<A, B>;
     using base::ua;
     using base::ub;
+    using base::which;
 
     template <std::size_t I>
     using getter=detail::either_get<I, A, B>;
 
+    template <std::size_t I>
+    using field_type=typename std::conditional<I==0, A, B>::type;
+
     template <std::size_t I>
     typename getter<I>::type& field() { return getter<I>::field(*this); }
 
     template <std::size_t I>
     const typename getter<I>::type& field() const { return getter<I>::field(*this); }
 
-    signed char which;
-
 public:
-    static constexpr signed char either_npos=-1;
+    using base::either_npos;
 
     // Can default construct if A or B is; try A first.
     template <
@@ -138,19 +461,27 @@ public:
         std::size_t w_ = a_ok? 0: 1
     >
     either()
-        noexcept(std::is_nothrow_default_constructible<typename getter<w_>::type>::value):
-        which(w_)
+        noexcept(std::is_nothrow_default_constructible<field_type<w_>>::value)
     {
-        getter<w_>::field(*this).constuct();
+        which=either_npos;
+        getter<w_>::field(*this).construct();
+        which=w_;
+    }
+
+    // Valueless, with its address recorded in `slot`.
+    explicit either(detail::result_slot<either>& slot) noexcept {
+        which=either_npos;
+        slot.target=this;
     }
 
     // Explicitly construct field in-place given by `in_place_index`.
     template <std::size_t w_, typename... Args>
     either(in_place_index_t<w_>, Args&&... args)
-        noexcept(std::is_nothrow_constructible<typename getter<w_>::type, Args...>::value):
-        which(w_)
+        noexcept(std::is_nothrow_constructible<field_type<w_>, Args...>::value)
     {
+        which=either_npos;
         getter<w_>::field(*this).construct(std::forward<Args>(args)...);
+        which=w_;
     }
 
 
@@ -164,10 +495,11 @@ public:
         std::size_t w_ = a_ok? 0: 1
     >
     either(in_place_t, Args&&... args)
-        noexcept(std::is_nothrow_constructible<typename getter<w_>::type, Args...>::value):
-        which(w_)
+        noexcept(std::is_nothrow_constructible<field_type<w_>, Args...>::value)
     {
+        which=either_npos;
         field<w_>().construct(std::forward<Args>(args)...);
+        which=w_;
     }
 
     // Implicit conversion from argument.
@@ -182,132 +514,109 @@ public:
         std::size_t w_ = a_ok? 0: 1
     >
     either(T&& x)
-        noexcept(std::is_nothrow_constructible<typename getter<w_>::type, T>::value):
-        which(w_)
+        noexcept(std::is_nothrow_constructible<field_type<w_>, T>::value)
     {
+        which=either_npos;
         field<w_>().construct(std::forward<T>(x));
+        which=w_;
     }
 
-    // Copy constructor.
-    either(const either& x)
-        noexcept(std::is_nothrow_copy_constructible<A>::value && std::is_nothrow_copy_constructible<B>::value):
-        which(x.which)
-    {
-        switch (which) {
+    // Uses-allocator construction: `alloc` is passed on to the
+    // constructor of the field if it accepts one (see `std::uses_allocator`).
+    template <
+        typename Alloc,
+        typename A_ = A,
+        bool a_ok = std::is_default_constructible<A_>::value,
+        bool b_ok = std::is_default_constructible<B>::value,
+        typename = typename std::enable_if<a_ok || b_ok>::type,
+        std::size_t w_ = a_ok? 0: 1
+    >
+    either(std::allocator_arg_t, const Alloc& alloc) {
+        which=either_npos;
+        field<w_>().construct_using_allocator(alloc);
+        which=w_;
+    }
+
+    template <typename Alloc, std::size_t w_, typename... Args>
+    either(std::allocator_arg_t, const Alloc& alloc, in_place_index_t<w_>, Args&&... args) {
+        which=either_npos;
+        field<w_>().construct_using_allocator(alloc, std::forward<Args>(args)...);
+        which=w_;
+    }
+
+    template <
+        typename Alloc,
+        typename T,
+        bool a_ok = std::is_lvalue_reference<A>::value? std::is_convertible<T&, A>::value: std::is_constructible<A, T>::value,
+        bool b_ok = std::is_lvalue_reference<B>::value? std::is_convertible<T&, B>::value: std::is_constructible<B, T>::value,
+        typename = typename std::enable_if<
+            (a_ok || b_ok) &&
+            !std::is_base_of<detail::ctor_tag, T>::value &&
+            !std::is_same<typename std::decay<T>::type, either>::value>::type,
+        std::size_t w_ = a_ok? 0: 1
+    >
+    either(std::allocator_arg_t, const Alloc& alloc, T&& x) {
+        which=either_npos;
+        field<w_>().construct_using_allocator(alloc, std::forward<T>(x));
+        which=w_;
+    }
+
+    template <typename Alloc>
+    either(std::allocator_arg_t, const Alloc& alloc, const either& x) {
+        which=either_npos;
+        switch (x.which) {
         case 0:
-            field<0>().construct(x.unsafe_get<0>());
+            copy_field<0>(alloc, x, std::is_reference<A>{});
             break;
         case 1:
-            field<1>().construct(x.unsafe_get<1>());
+            copy_field<1>(alloc, x, std::is_reference<B>{});
             break;
         }
+        which=x.which;
     }
 
-    // Move constructor.
-    either(either&& x)
-        noexcept(std::is_nothrow_move_constructible<A>::value && std::is_nothrow_move_constructible<B>::value):
-        which(x.which)
-    {
-        switch (which) {
+    template <typename Alloc>
+    either(std::allocator_arg_t, const Alloc& alloc, either&& x) {
+        which=either_npos;
+        switch (x.which) {
         case 0:
-            getter<0>::field(*this).construct(detail::ref_adaptor<A>::move(x.unsafe_get<0>()));
+            field<0>().construct_using_allocator(alloc, detail::either_forward<0>(std::move(x)));
             break;
         case 1:
-            getter<1>::field(*this).construct(detail::ref_adaptor<B>::move(x.unsafe_get<1>()));
+            field<1>().construct_using_allocator(alloc, detail::either_forward<1>(std::move(x)));
             break;
         }
+        which=x.which;
     }
 
-    // Copy assignment.
-    either& operator=(const either& x) {
-        if (which==0) {
-            if (x.which==0) {
-                getter<0>::field(*this).assign(x.unsafe_get<0>());
-            }
-            else if (x.which==1) {
-                auto b_tmp = detail::ref_adaptor<B>::from_ref(x.unsafe_get<1>());
-                field<0>().destruct();
-                which=(char)either_npos;
-                field<1>().construct(detail::ref_adaptor<B>::to_ref(std::move(b_tmp)));
-                which=1;
-            }
-            else {
-                field<0>().destruct();
-                which=(char)either_npos;
-            }
-        }
-        else if (which==1) {
-            if (x.which==0) {
-                auto a_tmp = detail::ref_adaptor<A>::from_ref(x.unsafe_get<0>());
-                field<1>().destruct();
-                which=(char)either_npos;
-                field<0>().construct(detail::ref_adaptor<A>::to_ref(std::move(a_tmp)));
-                which=0;
-            }
-            else if (which==1) {
-                getter<1>::field(*this).assign(x.unsafe_get<1>());
-            }
-            else {
-                field<1>().destruct();
-                which=(char)either_npos;
+    either(const either&)=default;
+    either(either&&)=default;
+    either& operator=(const either&)=default;
+    either& operator=(either&&)=default;
+
+    // Swap values; alternatives are swapped in place if both sides hold
+    // the same field, or else exchanged by move construction.
+    void swap(either& x)
+        noexcept(
+            std::is_nothrow_move_constructible<A>::value && std::is_nothrow_move_assignable<A>::value &&
+            std::is_nothrow_move_constructible<B>::value && std::is_nothrow_move_assignable<B>::value &&
+            detail::is_nothrow_swappable<A>::value && detail::is_nothrow_swappable<B>::value)
+    {
+        if (which==x.which) {
+            switch (which) {
+            case 0:
+                field<0>().swap(x.field<0>());
+                break;
+            case 1:
+                field<1>().swap(x.field<1>());
+                break;
             }
         }
         else {
-            if (x.which==0) {
-                getter<0>::field(*this).assign(x.unsafe_get<0>());
-                which=0;
-            }
-            else if (x.which==1) {
-                getter<1>::field(*this).assign(x.unsafe_get<1>());
-                which=1;
-            }
+            either tmp(std::move(x));
+            x=std::move(*this);
+            *this=std::move(tmp);
         }
-        return *this;
-    }
-
-    // Move assignment.
-    either& operator=(either&& x) {
-        if (which==0) {
-            if (x.which==0) {
-                getter<0>::field(*this).assign(std::move(x.unsafe_get<0>()));
-            }
-            else if (x.which==1) {
-                which=(char)either_npos;
-                field<0>().destruct();
-                field<1>().construct(detail::ref_adaptor<B>::move(x.unsafe_get<1>()));
-                which=1;
-            }
-            else {
-                which=(char)either_npos;
-                field<0>().destruct();
-            }
-        }
-        else if (which==1) {
-            if (x.which==0) {
-                which=(char)either_npos;
-                field<1>().destruct();
-                field<0>().construct(detail::ref_adaptor<A>::move(x.unsafe_get<0>()));
-                which=0;
-            }
-            else if (x.which==1) {
-                getter<1>::field(*this).assign(std::move(x.unsafe_get<1>()));
-            }
-            else {
-                which=(char)either_npos;
-                field<1>().destruct();
-            }
-        }
-        else {
-            if (x.which==0) {
-                field<0>().construct(detail::ref_adaptor<A>::move(x.unsafe_get<0>()));
-                which=0;
-            }
-            else if (x.which==1) {
-                field<1>().construct(detail::ref_adaptor<B>::move(x.unsafe_get<1>()));
-                which=1;
-            }
-        }
-        return *this;
     }
 
     // Element access.
@@ -334,64 +643,186 @@ public:
 
     // Index of defined field.
     constexpr std::size_t index() const noexcept { return which; }
-    constexpr bool valueless_by_exception() const noexcept { return which==(char)either_npos; }
+    constexpr bool valueless_by_exception() const noexcept { return which==either_npos; }
+
+    // Apply `f0` to the first field or `f1` to the second, whichever
+    // is occupied; throws `bad_either_access` if valueless.
+    template <typename F0, typename F1, typename R=detail::either_match_t<either&, F0, F1>>
+    R match(F0&& f0, F1&& f1) & { return detail::either_match<R>(*this, f0, f1); }
 
-    // Comparison operations.
+    template <typename F0, typename F1, typename R=detail::either_match_t<const either&, F0, F1>>
+    R match(F0&& f0, F1&& f1) const & { return detail::either_match<R>(*this, f0, f1); }
+
+    template <typename F0, typename F1, typename R=detail::either_match_t<either&&, F0, F1>>
+    R match(F0&& f0, F1&& f1) && { return detail::either_match<R>(std::move(*this), f0, f1); }
+
+    // Comparison operations: a valueless either orders before any
+    // other, then by field index, then by field value.
     bool operator==(const either& x) const {
-        return index()==x.index() &&
-           index()==0? unsafe_get<0>()==x.unsafe_get<0>():
-           index()==1? unsafe_get<1>()==x.unsafe_get<1>():
-           true;
+        return rank()==x.rank() && (!rank() || compare_field(x, detail::either_eq{}));
     }
 
     bool operator!=(const either& x) const {
-        return index()!=x.index() ||
-           index()==0? unsafe_get<0>()!=x.unsafe_get<0>():
-           index()==1? unsafe_get<1>()!=x.unsafe_get<1>():
-           false;
+        return rank()!=x.rank() || (rank() && compare_field(x, detail::either_ne{}));
     }
 
     bool operator<(const either& x) const {
-        return !x.valueless_by_exception() &&
-           index()==0? (x.index()==1 || unsafe_get<0>()<x.unsafe_get<0>()):
-           index()==1? (x.index()!=0 && unsafe_get<1>()<x.unsafe_get<1>()):
-           true;
+        return rank()!=x.rank()? rank()<x.rank(): rank() && compare_field(x, detail::either_lt{});
+    }
+
+    bool operator<=(const either& x) const {
+        return rank()!=x.rank()? rank()<x.rank(): !rank() || compare_field(x, detail::either_le{});
+    }
+
+    bool operator>(const either& x) const {
+        return rank()!=x.rank()? rank()>x.rank(): rank() && compare_field(x, detail::either_gt{});
     }
 
     bool operator>=(const either& x) const {
-        return x.valueless_by_exception() ||
-           index()==0? (x.index()!=1 && unsafe_get<0>()>=x.unsafe_get<0>()):
-           index()==1? (x.index()==0 || unsafe_get<1>()>=x.unsafe_get<1>()):
-           false;
+        return rank()!=x.rank()? rank()>x.rank(): !rank() || compare_field(x, detail::either_ge{});
     }
 
-    bool operator<=(const either& x) const {
-        return valueless_by_exception() ||
-           x.index()==0? (index()!=1 && unsafe_get<0>()<=x.unsafe_get<0>()):
-           x.index()==1? (index()==0 || unsafe_get<1>()<=x.unsafe_get<1>()):
-           false;
+private:
+    // Copy field I of `x` with uses-allocator construction; reference
+    // fields are copied as they are.
+    template <std::size_t I, typename Alloc>
+    void copy_field(const Alloc& alloc, const either& x, std::false_type) {
+        field<I>().construct_using_allocator(alloc, x.field<I>().cref());
     }
 
-    bool operator>(const either& x) const {
-        return !valueless_by_exception() &&
-           x.index()==0? (index()==1 || unsafe_get<0>()>x.unsafe_get<0>()):
-           x.index()==1? (index()!=0 && unsafe_get<1>()>x.unsafe_get<1>()):
-           true;
+    template <std::size_t I, typename Alloc>
+    void copy_field(const Alloc&, const either& x, std::true_type) {
+        field<I>()=x.field<I>();
     }
 
-    // Destruction.
-    ~either() {
-        switch (which) {
-        case 0:
-            field<0>().destruct();
-            break;
-        case 1:
-            field<1>().destruct();
-            break;
-        }
+    // Field index plus one, or zero if valueless.
+    std::size_t rank() const { return std::size_t(index()+1); }
+
+    // Compare fields with `op`; `x` must hold the same field.
+    template <typename Op>
+    bool compare_field(const either& x, Op op) const {
+        return match(
+            [&](typename getter<0>::type::const_reference a) { return op(a, x.unsafe_get<0>()); },
+            [&](typename getter<1>::type::const_reference b) { return op(b, x.unsafe_get<1>()); });
     }
 };
 
+template <typename A, typename B>
+struct is_trivially_relocatable<either<A, B>>:
+    std::integral_constant<bool, is_trivially_relocatable<A>::value && is_trivially_relocatable<B>::value> {};
+
+template <typename A, typename B>
+void swap(either<A, B>& a, either<A, B>& b) noexcept(noexcept(a.swap(b))) { a.swap(b); }
+
+// Apply `f` to the occupied field of `e`. Call as `hf::visit` where
+// `std::visit` may also be found by argument-dependent lookup.
+template <typename F, typename E, typename = typename std::enable_if<detail::is_either<E>::value>::type>
+auto visit(F&& f, E&& e) -> decltype(std::forward<E>(e).match(f, f)) {
+    return std::forward<E>(e).match(f, f);
+}
+
+// Apply `f` to the occupied fields of `a` and `b`.
+template <
+    typename F, typename E1, typename E2,
+    typename = typename std::enable_if<detail::is_either<E1>::value && detail::is_either<E2>::value>::type,
+    typename R = detail::either_visit_t<F, E1, E2>
+>
+R visit(F&& f, E1&& a, E2&& b) {
+    return detail::either_visit_table<R, F, E1, E2>::visit(f, std::forward<E1>(a), std::forward<E2>(b));
+}
+
+namespace detail {
+    template <typename... E>
+    struct all_either: std::true_type {};
+
+    template <typename E, typename... Es>
+    struct all_either<E, Es...>: std::integral_constant<bool, is_either<E>::value && all_either<Es...>::value> {};
+
+    template <typename E>
+    struct either_error_type {
+        typedef typename std::decay<E>::type either_type;
+        typedef typename std::decay<decltype(std::declval<either_type&>().template unsafe_get<1>())>::type type;
+    };
+
+    // Indices are combined with `&` rather than `&&`, so that they are
+    // tested together rather than one branch at a time.
+    inline bool all_left() { return true; }
+
+    template <typename E, typename... Es>
+    bool all_left(const E& e, const Es&... es) { return (e.index()==0) & all_left(es...); }
+
+    // The error held by the first argument not holding a value.
+    template <typename R>
+    R either_first_error() { throw bad_either_access("apply to valueless either"); }
+
+    template <typename R, typename E, typename... Es>
+    R either_first_error(E&& e, Es&&... es) {
+        if (e.index()==0) return either_first_error<R>(std::forward<Es>(es)...);
+        if (e.index()!=1) throw bad_either_access("apply to valueless either");
+        return R(in_place_index_t<1>{}, either_forward<1>(std::forward<E>(e)));
+    }
+
+    template <typename F, typename... E>
+    using either_apply_result_t=decltype(std::declval<F>()(either_forward<0>(std::declval<E>())...));
+
+    // Results of type either<X, Err> are returned as is; others are
+    // wrapped as field 0.
+    template <typename F_result_type, typename Err>
+    struct either_lift_type { typedef either<F_result_type, Err> type; };
+
+    template <typename X, typename Err>
+    struct either_lift_type<either<X, Err>, Err> { typedef either<X, Err> type; };
+
+    template <typename R, typename F_result_type>
+    struct either_apply_impl {
+        template <typename F, typename... A>
+        static R apply(F&& f, A&&... a) { return R(in_place_index_t<0>{}, std::forward<F>(f)(std::forward<A>(a)...)); }
+    };
+
+    template <typename R>
+    struct either_apply_impl<R, R> {
+        template <typename F, typename... A>
+        static R apply(F&& f, A&&... a) { return std::forward<F>(f)(std::forward<A>(a)...); }
+    };
+} // namespace detail
+
+// Multi-argument bind over eithers holding a value in field 0 or an
+// error in field 1: if every argument holds a value, the result of `f`
+// applied to these, as field 0; otherwise the first error. Errors take
+// the type of that of the first argument. Call as `hf::apply` where
+// `std::apply` may also be found by argument-dependent lookup.
+template <
+    typename F, typename E, typename... Es,
+    typename = typename std::enable_if<detail::all_either<E, Es...>::value>::type,
+    typename F_result_type = detail::either_apply_result_t<F, E&&, Es&&...>,
+    typename R = typename detail::either_lift_type<F_result_type, typename detail::either_error_type<E>::type>::type
+>
+R apply(F&& f, E&& e, Es&&... es) {
+    static_assert(!std::is_void<F_result_type>::value, "apply to either requires a function returning a value");
+
+    if (!detail::all_left(e, es...)) return detail::either_first_error<R>(std::forward<E>(e), std::forward<Es>(es)...);
+    return detail::either_apply_impl<R, F_result_type>::apply(std::forward<F>(f),
+        detail::either_forward<0>(std::forward<E>(e)), detail::either_forward<0>(std::forward<Es>(es))...);
+}
+
+namespace detail {
+    struct lift_tag;
+
+    // Support for `lift(f)` (see optional.h) over either arguments.
+    template <typename F, typename... E, typename std::enable_if<(sizeof...(E)>0) && all_either<E...>::value, int>::type = 0>
+    auto lifted_call(const lift_tag&, F& f, E&&... e) -> decltype(hf::apply(f, std::forward<E>(e)...)) {
+        return hf::apply(f, std::forward<E>(e)...);
+    }
+} // namespace detail
+
 } // namespace hf
 
+namespace std {
+
+template <typename A, typename B, typename Alloc>
+struct uses_allocator<hf::either<A, B>, Alloc>:
+    integral_constant<bool, uses_allocator<A, Alloc>::value || uses_allocator<B, Alloc>::value> {};
+
+} // namespace std
+
 #endif // ndef HF_EITHER_H_
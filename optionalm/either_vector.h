@@ -0,0 +1,213 @@
+#ifndef HF_EITHER_VECTOR_H_
+#define HF_EITHER_VECTOR_H_
+
+/* Sequence of `either<A, B>` values stored by alternative.
+ *
+ * An `either_vector<A, B>` keeps the `A` and `B` values in two dense
+ * vectors, together with a slot array recording for each element its
+ * field index and its offset in the corresponding vector.
+ *
+ * Elements can be accessed in sequence order through `operator[]`,
+ * which returns an `either` of references, but the intended use is
+ * bulk processing of each alternative through `lefts()`, `rights()`,
+ * `for_each_left()` and `for_each_right()`, which involve no
+ * per-element branch on the field index. `lefts()` and `rights()`
+ * give spans over the dense storage, through which elements may be
+ * modified but not added or removed.
+ *
+ * Neither alternative may be `bool`, as `std::vector<bool>` does not
+ * hold `bool` objects to which references can be returned.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <optionalm/either.h>
+
+namespace hf {
+
+namespace detail {
+    // Contiguous sequence of elements owned elsewhere.
+    template <typename X>
+    class dense_span {
+        X* begin_;
+        X* end_;
+
+    public:
+        typedef X value_type;
+        typedef X* iterator;
+        typedef std::size_t size_type;
+
+        dense_span(X* begin, X* end): begin_(begin), end_(end) {}
+
+        X* begin() const { return begin_; }
+        X* end() const { return end_; }
+        X* data() const { return begin_; }
+
+        size_type size() const { return end_-begin_; }
+        bool empty() const { return begin_==end_; }
+
+        X& operator[](size_type i) const { return begin_[i]; }
+    };
+} // namespace detail
+
+template <typename A, typename B>
+class either_vector {
+    static_assert(!std::is_reference<A>::value && !std::is_reference<B>::value,
+        "either_vector alternatives must be value types");
+    static_assert(!std::is_same<typename std::remove_cv<A>::type, bool>::value &&
+        !std::is_same<typename std::remove_cv<B>::type, bool>::value,
+        "either_vector alternatives cannot be bool");
+
+    std::vector<A> lefts_;
+    std::vector<B> rights_;
+
+    // Offset into lefts_ or rights_, shifted left by one, with the
+    // field index in the low bit.
+    std::vector<std::size_t> slots_;
+
+public:
+    typedef either<A, B> value_type;
+    typedef either<A&, B&> reference;
+    typedef either<const A&, const B&> const_reference;
+    typedef std::size_t size_type;
+    typedef detail::dense_span<A> left_span;
+    typedef detail::dense_span<const A> const_left_span;
+    typedef detail::dense_span<B> right_span;
+    typedef detail::dense_span<const B> const_right_span;
+
+    either_vector() {}
+
+    template <typename InputIt>
+    either_vector(InputIt first, InputIt last) {
+        for (; first!=last; ++first) push_back(*first);
+    }
+
+    size_type size() const { return slots_.size(); }
+    bool empty() const { return slots_.empty(); }
+
+    size_type count_left() const { return lefts_.size(); }
+    size_type count_right() const { return rights_.size(); }
+
+    void reserve(size_type n) { slots_.reserve(n); }
+
+    void reserve(size_type n_left, size_type n_right) {
+        slots_.reserve(n_left+n_right);
+        lefts_.reserve(n_left);
+        rights_.reserve(n_right);
+    }
+
+    void clear() {
+        slots_.clear();
+        lefts_.clear();
+        rights_.clear();
+    }
+
+    // Field index of the ith element.
+    std::size_t index(size_type i) const { return slots_[i]&1; }
+
+    reference operator[](size_type i) {
+        std::size_t s=slots_[i];
+        return s&1? reference(in_place_index_t<1>{}, rights_[s>>1]): reference(in_place_index_t<0>{}, lefts_[s>>1]);
+    }
+
+    const_reference operator[](size_type i) const {
+        std::size_t s=slots_[i];
+        return s&1? const_reference(in_place_index_t<1>{}, rights_[s>>1]): const_reference(in_place_index_t<0>{}, lefts_[s>>1]);
+    }
+
+    template <typename... Args>
+    A& emplace_left(Args&&... args) {
+        slots_.push_back(lefts_.size()<<1);
+        try {
+            lefts_.emplace_back(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            slots_.pop_back();
+            throw;
+        }
+        return lefts_.back();
+    }
+
+    template <typename... Args>
+    B& emplace_right(Args&&... args) {
+        slots_.push_back(rights_.size()<<1 | 1);
+        try {
+            rights_.emplace_back(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            slots_.pop_back();
+            throw;
+        }
+        return rights_.back();
+    }
+
+    void push_back(const value_type& x) {
+        switch (x.index()) {
+        case 0:
+            emplace_left(x.template unsafe_get<0>());
+            break;
+        case 1:
+            emplace_right(x.template unsafe_get<1>());
+            break;
+        default:
+            throw bad_either_access("push_back of valueless either");
+        }
+    }
+
+    void push_back(value_type&& x) {
+        switch (x.index()) {
+        case 0:
+            emplace_left(std::move(x.template unsafe_get<0>()));
+            break;
+        case 1:
+            emplace_right(std::move(x.template unsafe_get<1>()));
+            break;
+        default:
+            throw bad_either_access("push_back of valueless either");
+        }
+    }
+
+    void pop_back() {
+        if (slots_.back()&1) rights_.pop_back();
+        else lefts_.pop_back();
+        slots_.pop_back();
+    }
+
+    // Dense storage of each alternative, in sequence order.
+    left_span lefts() { return left_span(lefts_.data(), lefts_.data()+lefts_.size()); }
+    const_left_span lefts() const { return const_left_span(lefts_.data(), lefts_.data()+lefts_.size()); }
+
+    right_span rights() { return right_span(rights_.data(), rights_.data()+rights_.size()); }
+    const_right_span rights() const { return const_right_span(rights_.data(), rights_.data()+rights_.size()); }
+
+    template <typename F>
+    F for_each_left(F f) {
+        for (auto& a: lefts_) f(a);
+        return f;
+    }
+
+    template <typename F>
+    F for_each_left(F f) const {
+        for (const auto& a: lefts_) f(a);
+        return f;
+    }
+
+    template <typename F>
+    F for_each_right(F f) {
+        for (auto& b: rights_) f(b);
+        return f;
+    }
+
+    template <typename F>
+    F for_each_right(F f) const {
+        for (const auto& b: rights_) f(b);
+        return f;
+    }
+};
+
+} // namespace hf
+
+#endif // ndef HF_EITHER_VECTOR_H_
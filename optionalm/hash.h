@@ -0,0 +1,126 @@
+#ifndef HF_HASH_H_
+#define HF_HASH_H_
+
+/* Hashing of `optional` and `either` values.
+ *
+ * `std::hash` is specialized for `optional<X>` and `either<A, B>`.
+ * The hash combines the hash of the held value with the presence flag
+ * or field index, so that an unset optional and a set optional holding
+ * a zero value, or the same value held in different fields of an
+ * either, hash differently.
+ *
+ * `hash_batch(first, last, out)` writes the hashes of a sequence of
+ * optional or either values to `out`; these are the same as those
+ * given by `std::hash`. Integral and enum payloads are hashed by
+ * value and masked by the presence flag rather than branched on, so
+ * that the hashes of consecutive optionals are computed independently
+ * and without a data-dependent branch. (The 64-bit multiplies of the
+ * mix do not vectorize without AVX-512; staging blocks of masked
+ * payloads before mixing them measured slower than this single loop.)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#include <optionalm/optional.h>
+#include <optionalm/either.h>
+
+namespace hf {
+
+namespace detail {
+    // Finalizer of MurmurHash3: a bijection on 64-bit words in which
+    // each input bit affects each output bit.
+    inline std::uint64_t hash_mix(std::uint64_t h) {
+        h ^= h>>33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h>>33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h>>33;
+        return h;
+    }
+
+    // Hash of a payload hash `h` with presence flag or field index `tag`.
+    inline std::size_t hash_tagged(std::uint64_t h, std::uint64_t tag) {
+        return static_cast<std::size_t>(hash_mix(h ^ tag*0x9e3779b97f4a7c15ull));
+    }
+
+    // Integral and enum payloads are mixed directly; other payloads
+    // are hashed with `std::hash` first.
+    template <typename X, bool direct=std::is_integral<X>::value || std::is_enum<X>::value>
+    struct hash_payload {
+        std::uint64_t operator()(const X& x) const { return std::hash<X>()(x); }
+    };
+
+    template <typename X>
+    struct hash_payload<X, true> {
+        std::uint64_t operator()(const X& x) const { return static_cast<std::uint64_t>(x); }
+    };
+
+    template <typename X>
+    std::uint64_t hash_payload_of(const X& x) {
+        return hash_payload<typename std::decay<X>::type>()(x);
+    }
+
+    template <typename X, bool direct=std::is_integral<X>::value || std::is_enum<X>::value>
+    struct hash_optional {
+        static std::size_t apply(const optional<X>& o) {
+            return hash_tagged(o? hash_payload_of(*o): 0, o? 1: 0);
+        }
+    };
+
+    // The payload bytes are read whether or not the optional is set, and
+    // masked by the presence flag, so that there is no branch.
+    template <typename X>
+    struct hash_optional<X, true> {
+        static std::size_t apply(const optional<X>& o) {
+            std::uint64_t set=o? 1: 0;
+            return hash_tagged(hash_payload_of(optional_raw_value(o)) & -set, set);
+        }
+    };
+
+    template <typename X>
+    std::size_t hash_value(const optional<X>& o) {
+        return hash_optional<X>::apply(o);
+    }
+
+    inline std::size_t hash_value(const optional<void>& o) {
+        return hash_tagged(0, o? 1: 0);
+    }
+
+    // Field index is offset by one, so that a valueless either has tag zero.
+    template <typename A, typename B>
+    std::size_t hash_value(const either<A, B>& e) {
+        std::size_t i=e.index();
+        std::uint64_t h=
+            i==0? hash_payload_of(e.template unsafe_get<0>()):
+            i==1? hash_payload_of(e.template unsafe_get<1>()): 0;
+        return hash_tagged(h, i+1);
+    }
+} // namespace detail
+
+// Write the hash of each optional or either in [first, last) to `out`.
+template <typename InputIt, typename OutputIt>
+OutputIt hash_batch(InputIt first, InputIt last, OutputIt out) {
+    for (; first!=last; ++first) *out++ = detail::hash_value(*first);
+    return out;
+}
+
+} // namespace hf
+
+namespace std {
+
+template <typename X>
+struct hash<hf::optional<X>> {
+    std::size_t operator()(const hf::optional<X>& o) const { return hf::detail::hash_value(o); }
+};
+
+template <typename A, typename B>
+struct hash<hf::either<A, B>> {
+    std::size_t operator()(const hf::either<A, B>& e) const { return hf::detail::hash_value(e); }
+};
+
+} // namespace std
+
+#endif // ndef HF_HASH_H_
@@ -0,0 +1,232 @@
+#ifndef HF_OBJECT_POOL_H_
+#define HF_OBJECT_POOL_H_
+
+/* Pool of objects of one type, allocated in chunks.
+ *
+ * `object_pool<T>` holds objects in chunks of `uninitialized<T>` slots.
+ * Unused slots are linked into a free list through their own storage,
+ * so that acquiring or releasing an object is a push or pop on that
+ * list, and allocates only when a new chunk is needed.
+ *
+ * `acquire(args...)` constructs an object in a free slot and returns a
+ * reference to it as an `optional<T&>`, unset if the pool has reached
+ * its maximum size or a chunk could not be allocated. An exception
+ * thrown by the constructor of `T` is propagated. `release(x)` destroys
+ * the object and frees its slot. `make(args...)` returns instead an
+ * owning `object_pool<T>::handle`, which releases the object when
+ * destroyed, and is empty if the object could not be acquired.
+ *
+ * The pool may be used from several threads: its free list is guarded
+ * by a mutex. An `object_pool<T>::cache`, used by one thread at a time,
+ * keeps a local list of free slots, moving slots to or from the pool
+ * in batches, so that most acquisitions and releases through it take
+ * no lock. Objects may be released through any cache of the same pool
+ * or through the pool itself; a cache returns its slots to the pool
+ * when destroyed.
+ *
+ * All objects must be released, and all caches destroyed, before the
+ * pool itself is destroyed.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/uninitialized.h>
+
+namespace hf {
+
+namespace detail {
+    // Storage of a pool object, or while unused, a link in the free list.
+    template <typename T>
+    union pool_slot {
+        uninitialized<T> value;
+        pool_slot* next;
+    };
+
+    // Singly-linked list of free slots.
+    template <typename T>
+    struct pool_list {
+        pool_slot<T>* head=nullptr;
+        std::size_t size=0;
+
+        void push(pool_slot<T>* s) {
+            s->next=head;
+            head=s;
+            ++size;
+        }
+
+        pool_slot<T>* pop() {
+            pool_slot<T>* s=head;
+            head=s->next;
+            --size;
+            return s;
+        }
+
+        // Move up to n slots from the front of this list to `to`.
+        void splice(pool_list& to, std::size_t n) {
+            for (n=std::min(n, size); n>0; --n) to.push(pop());
+        }
+    };
+} // namespace detail
+
+template <typename T>
+class object_pool {
+    typedef detail::pool_slot<T> slot;
+    typedef detail::pool_list<T> list;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<slot[]>> chunks_;
+    list free_;
+    std::size_t capacity_=0;
+    std::size_t chunk_size_;
+    std::size_t max_size_;
+
+    // Precondition: mutex_ is held.
+    bool grow() {
+        std::size_t n=std::min(chunk_size_, max_size_-capacity_);
+        if (!n) return false;
+
+        std::unique_ptr<slot[]> chunk(new (std::nothrow) slot[n]);
+        if (!chunk) return false;
+        try {
+            chunks_.reserve(chunks_.size()+1);
+        }
+        catch (std::bad_alloc&) {
+            return false;
+        }
+
+        for (std::size_t i=n; i>0; --i) free_.push(&chunk[i-1]);
+        chunks_.push_back(std::move(chunk));
+        capacity_+=n;
+        return true;
+    }
+
+    // Move up to n free slots to `to`, growing the pool if there are none.
+    void take(list& to, std::size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.size) grow();
+        free_.splice(to, n);
+    }
+
+    void give(list& from, std::size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        from.splice(free_, n);
+    }
+
+    static slot* slot_of(T& x) { return reinterpret_cast<slot*>(&x); }
+
+    template <typename... Args>
+    static optional<T&> construct(list& from, Args&&... args) {
+        slot* s=from.pop();
+        try {
+            s->value.construct(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            from.push(s);
+            throw;
+        }
+        return s->value.ref();
+    }
+
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+
+    struct releaser {
+        object_pool* pool;
+        void operator()(T* p) const { pool->release(*p); }
+    };
+
+    typedef std::unique_ptr<T, releaser> handle;
+
+    explicit object_pool(size_type chunk_size=64, size_type max_size=std::numeric_limits<size_type>::max()):
+        chunk_size_(chunk_size? chunk_size: 1), max_size_(max_size)
+    {}
+
+    object_pool(const object_pool&)=delete;
+    object_pool& operator=(const object_pool&)=delete;
+
+    // Number of slots allocated, and of those free in the pool (not
+    // counting those held in caches).
+    size_type capacity() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    size_type available() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size;
+    }
+
+    template <typename... Args>
+    optional<T&> acquire(Args&&... args) {
+        list one;
+        take(one, 1);
+        if (!one.size) return nothing;
+
+        try {
+            return construct(one, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            give(one, 1);
+            throw;
+        }
+    }
+
+    void release(T& x) {
+        x.~T();
+        list one;
+        one.push(slot_of(x));
+        give(one, 1);
+    }
+
+    template <typename... Args>
+    handle make(Args&&... args) {
+        optional<T&> x=acquire(std::forward<Args>(args)...);
+        return handle(x? &*x: nullptr, releaser{this});
+    }
+
+    class cache {
+        object_pool* pool_;
+        list free_;
+        size_type batch_;
+
+    public:
+        // Slots are moved to or from the pool `batch` at a time; the cache
+        // holds at most twice that many.
+        explicit cache(object_pool& pool, size_type batch=32): pool_(&pool), batch_(batch? batch: 1) {}
+
+        cache(const cache&)=delete;
+        cache& operator=(const cache&)=delete;
+
+        ~cache() { pool_->give(free_, free_.size); }
+
+        size_type cached() const { return free_.size; }
+
+        template <typename... Args>
+        optional<T&> acquire(Args&&... args) {
+            if (!free_.size) {
+                pool_->take(free_, batch_);
+                if (!free_.size) return nothing;
+            }
+            return construct(free_, std::forward<Args>(args)...);
+        }
+
+        void release(T& x) {
+            x.~T();
+            free_.push(slot_of(x));
+            if (free_.size>2*batch_) pool_->give(free_, batch_);
+        }
+    };
+};
+
+} // namespace hf
+
+#endif // ndef HF_OBJECT_POOL_H_
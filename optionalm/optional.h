@@ -17,10 +17,22 @@
 #ifndef HF_OPTIONALM_H_
 #define HF_OPTIONALM_H_
 
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <type_traits>
 #include <stdexcept>
 #include <utility>
 
+#if defined(__cpp_impl_three_way_comparison)
+#include <compare>
+#endif
+
+#if __cplusplus>=202002L
+#include <ranges>
+#endif
+
 #include <optionalm/uninitialized.h>
 
 #pragma clang diagnostic push
@@ -59,6 +71,12 @@ namespace detail {
 
     template <typename X> struct wrapped_type { typedef typename wrapped_type_<typename std::decay<X>::type, X>::type type; };
 
+    // The storage of an unset optional of arithmetic or enum type is
+    // kept zeroed, so that it may be read without testing the flag
+    // (see `optional_raw_value`).
+    template <typename X>
+    struct optional_zeroed: std::integral_constant<bool, std::is_arithmetic<X>::value || std::is_enum<X>::value> {};
+
     template <typename X>
     struct optional_base: detail::optional_tag {
         template <typename Y> friend struct optional;
@@ -76,18 +94,28 @@ namespace detail {
         bool set;
         D data;
 
-        optional_base(): set(false) {}
+        optional_base(): set(false) { clear_unset(); }
 
         template <typename T>
-        optional_base(bool set_, T&& init): set(set_) { if (set) data.construct(std::forward<T>(init)); }
+        optional_base(bool set_, T&& init): set(set_) {
+            if (set) data.construct(std::forward<T>(init));
+            else clear_unset();
+        }
+
+        template <typename... Args>
+        explicit optional_base(in_place_t, Args&&... args): set(true) { data.construct(std::forward<Args>(args)...); }
 
         reference ref() { return data.ref(); }
         const_reference ref() const { return data.cref(); }
 
+        void clear_unset() { clear_unset(optional_zeroed<X>{}); }
+        void clear_unset(std::false_type) {}
+        void clear_unset(std::true_type) { std::memset(static_cast<void*>(data.ptr()), 0, sizeof(X)); }
+
     public:
         ~optional_base() { if (set) data.destruct(); }
 
-        const_pointer operator->() const { return data.ptr(); }
+        const_pointer operator->() const { return data.cptr(); }
         pointer operator->() { return data.ptr(); }
 
         const_reference operator*() const { return ref(); }
@@ -105,54 +133,109 @@ namespace detail {
 
         explicit operator bool() const { return set; }
 
+        // An optional is a range of zero or one elements.
+        pointer begin() { return set? data.ptr(): pointer(); }
+        pointer end() { return begin()+set; }
+
+        const_pointer begin() const { return set? data.cptr(): const_pointer(); }
+        const_pointer end() const { return begin()+set; }
+
         template <typename Y>
         bool operator==(const Y& y) const { return set && ref()==y; }
 
-        template <typename Y>
-        bool operator==(const optional<Y>& o) const {
-            return set && o.set && ref()==o.ref() || !set && !o.set;
-        }
 
         void reset() {
-            if (set) data.destruct();
+            if (set) {
+                data.destruct();
+                clear_unset();
+            }
             set=false;
         }
 
         template <typename F>
-        auto bind(F&& f) -> typename lift_type<decltype(data.apply(std::forward<F>(f)))>::type {
+        auto bind(F&& f) & -> typename lift_type<decltype(data.apply(std::forward<F>(f)))>::type {
             typedef decltype(data.apply(std::forward<F>(f))) F_result_type;
             typedef typename lift_type<F_result_type>::type result_type;
 
             if (!set) return result_type();
-            else return bind_impl<result_type, std::is_same<F_result_type, void>::value>::bind(data, std::forward<F>(f));
+            else return bind_impl<result_type, F_result_type>::bind(data, std::forward<F>(f));
         }
 
         template <typename F>
-        auto bind(F&& f) const -> typename lift_type<decltype(data.apply(std::forward<F>(f)))>::type {
+        auto bind(F&& f) const& -> typename lift_type<decltype(data.apply(std::forward<F>(f)))>::type {
             typedef decltype(data.apply(std::forward<F>(f))) F_result_type;
             typedef typename lift_type<F_result_type>::type result_type;
 
             if (!set) return result_type();
-            else return bind_impl<result_type, std::is_same<F_result_type, void>::value>::bind(data, std::forward<F>(f));
+            else return bind_impl<result_type, F_result_type>::bind(data, std::forward<F>(f));
+        }
+
+        // Binding to an rvalue passes the value to `f` as an rvalue.
+        template <typename F>
+        auto bind(F&& f) && -> typename lift_type<decltype(std::move(data).apply(std::forward<F>(f)))>::type {
+            typedef decltype(std::move(data).apply(std::forward<F>(f))) F_result_type;
+            typedef typename lift_type<F_result_type>::type result_type;
+
+            if (!set) return result_type();
+            else return bind_impl<result_type, F_result_type>::bind(std::move(data), std::forward<F>(f));
         }
 
         template <typename F>
-        auto operator>>(F&& f) -> decltype(this->bind(std::forward<F>(f))) { return bind(std::forward<F>(f)); }
+        auto operator>>(F&& f) & -> decltype(this->bind(std::forward<F>(f))) { return bind(std::forward<F>(f)); }
 
         template <typename F>
-        auto operator>>(F&& f) const -> decltype(this->bind(std::forward<F>(f))) { return bind(std::forward<F>(f)); }
+        auto operator>>(F&& f) const& -> decltype(this->bind(std::forward<F>(f))) { return bind(std::forward<F>(f)); }
+
+        template <typename F>
+        auto operator>>(F&& f) && -> decltype(std::move(*this).bind(std::forward<F>(f))) {
+            return std::move(*this).bind(std::forward<F>(f));
+        }
+
+        // Lazy alternative to `operator|`: return this value if set,
+        // otherwise the result of `f()`, which is only evaluated if needed.
+        template <typename F>
+        optional<X> or_else(F&& f) const& {
+            return set? optional<X>(derived()): optional<X>(std::forward<F>(f)());
+        }
+
+        template <typename F>
+        optional<X> or_else(F&& f) && {
+            return set? optional<X>(std::move(derived())): optional<X>(std::forward<F>(f)());
+        }
+
+        // Lazy alternative to `operator&`: if set, return the (lifted)
+        // result of `f()`, otherwise an unset value; `f` takes no arguments.
+        template <typename F>
+        auto and_then(F&& f) const -> typename lift_type<decltype(std::forward<F>(f)())>::type {
+            typedef decltype(std::forward<F>(f)()) F_result_type;
+            typedef typename lift_type<F_result_type>::type result_type;
+
+            hf::uninitialized<void> nullary;
+            if (!set) return result_type();
+            else return bind_impl<result_type, F_result_type>::bind(nullary, std::forward<F>(f));
+        }
 
     private:
-        template <typename R, bool F_void_return>
+        optional<X>& derived() { return static_cast<optional<X>&>(*this); }
+        const optional<X>& derived() const { return static_cast<const optional<X>&>(*this); }
+
+        template <typename R, typename F_result_type>
         struct bind_impl {
             template <typename DT, typename F>
-            static R bind(DT& d, F&& f) { return R(d.apply(std::forward<F>(f))); }
+            static R bind(DT&& d, F&& f) { return R(std::forward<DT>(d).apply(std::forward<F>(f))); }
         };
 
         template <typename R>
-        struct bind_impl<R, true> {
+        struct bind_impl<R, void> {
             template <typename DT, typename F>
-            static R bind(DT& d, F&& f) { d.apply(std::forward<F>(f)); return R(true); }
+            static R bind(DT&& d, F&& f) { std::forward<DT>(d).apply(std::forward<F>(f)); return R(true); }
+        };
+
+        // `f` already returns an optional: return it as is.
+        template <typename R>
+        struct bind_impl<R, R> {
+            template <typename DT, typename F>
+            static R bind(DT&& d, F&& f) { return std::forward<DT>(d).apply(std::forward<F>(f)); }
         };
     };
 
@@ -179,6 +262,15 @@ struct optional: detail::optional_base<X> {
         noexcept(std::is_nothrow_move_constructible<X>::value):
         base(true, std::move(x)) {}
 
+    // Unset, with its address recorded in `slot`.
+    explicit optional(detail::result_slot<optional>& slot) noexcept: base() { slot.target=this; }
+
+    // Construct value in place from the arguments following `in_place`.
+    template <typename... Args>
+    explicit optional(in_place_t, Args&&... args)
+        noexcept(std::is_nothrow_constructible<X, Args&&...>::value):
+        base(in_place, std::forward<Args>(args)...) {}
+
     optional(const optional& ot)
         noexcept(std::is_nothrow_copy_constructible<X>::value):
         base(ot.set, ot.ref()) {}
@@ -197,7 +289,57 @@ struct optional: detail::optional_base<X> {
         noexcept(std::is_nothrow_constructible<X, T&&>::value):
         base(ot.set, std::move(ot.ref())) {}
 
-    optional& operator=(nothing_t) { return reset(), *this; }
+    // Uses-allocator construction: `alloc` is passed on to the value's
+    // constructor if it accepts one (see `std::uses_allocator`).
+    template <typename Alloc>
+    optional(std::allocator_arg_t, const Alloc&) noexcept: base() {}
+
+    template <typename Alloc>
+    optional(std::allocator_arg_t, const Alloc&, nothing_t) noexcept: base() {}
+
+    template <
+        typename Alloc, typename T,
+        typename =detail::enable_unless_optional_t<T>,
+        typename =typename std::enable_if<std::is_constructible<X, T&&>::value>::type
+    >
+    optional(std::allocator_arg_t, const Alloc& alloc, T&& x): base() {
+        data.construct_using_allocator(alloc, std::forward<T>(x));
+        set=true;
+    }
+
+    template <typename Alloc, typename... Args>
+    optional(std::allocator_arg_t, const Alloc& alloc, in_place_t, Args&&... args): base() {
+        data.construct_using_allocator(alloc, std::forward<Args>(args)...);
+        set=true;
+    }
+
+    template <typename Alloc, typename T>
+    optional(std::allocator_arg_t, const Alloc& alloc, const optional<T>& ot): base() {
+        if (ot.set) {
+            data.construct_using_allocator(alloc, ot.ref());
+            set=true;
+        }
+    }
+
+    template <typename Alloc, typename T>
+    optional(std::allocator_arg_t, const Alloc& alloc, optional<T>&& ot): base() {
+        if (ot.set) {
+            data.construct_using_allocator(alloc, std::move(ot.ref()));
+            set=true;
+        }
+    }
+
+    optional& operator=(nothing_t) noexcept { return reset(), *this; }
+
+    // Destroy any current value and construct a new one in place;
+    // if construction throws, the optional is left unset.
+    template <typename... Args>
+    X& emplace(Args&&... args) {
+        reset();
+        data.construct(std::forward<Args>(args)...);
+        set=true;
+        return ref();
+    }
 
     template <typename Y, typename =detail::enable_unless_optional_t<Y>>
     optional& operator=(Y&& y) {
@@ -209,7 +351,9 @@ struct optional: detail::optional_base<X> {
         return *this;
     }
 
-    optional& operator=(const optional& o) {
+    optional& operator=(const optional& o)
+        noexcept(std::is_nothrow_copy_constructible<X>::value && std::is_nothrow_copy_assignable<X>::value)
+    {
         if (set) {
             if (o.set) ref()=o.ref();
             else reset();
@@ -225,7 +369,9 @@ struct optional: detail::optional_base<X> {
         std::is_move_assignable<Y>::value &&
         std::is_move_constructible<Y>::value
     >::type>
-    optional& operator=(optional&& o) {
+    optional& operator=(optional&& o)
+        noexcept(std::is_nothrow_move_constructible<Y>::value && std::is_nothrow_move_assignable<Y>::value)
+    {
         if (set) {
             if (o.set) ref()=std::move(o.ref());
             else reset();
@@ -236,6 +382,22 @@ struct optional: detail::optional_base<X> {
         }
         return *this;
     }
+
+    void swap(optional& o)
+        noexcept(std::is_nothrow_move_constructible<X>::value && detail::is_nothrow_swappable<X>::value)
+    {
+        if (set && o.set) data.swap(o.data);
+        else if (set) {
+            o.data.construct(std::move(ref()));
+            o.set=true;
+            reset();
+        }
+        else if (o.set) {
+            data.construct(std::move(o.ref()));
+            set=true;
+            o.reset();
+        }
+    }
 };
 
 template <typename X>
@@ -250,6 +412,9 @@ struct optional<X&>: detail::optional_base<X&> {
     optional(nothing_t) noexcept: base() {}
     optional(X& x) noexcept: base(true, x) {}
 
+    // Unset, with its address recorded in `slot`.
+    explicit optional(detail::result_slot<optional>& slot) noexcept: base() { slot.target=this; }
+
     template <typename T>
     optional(optional<T&>& ot) noexcept: base(ot.set, ot.ref()) {}
 
@@ -268,6 +433,11 @@ struct optional<X&>: detail::optional_base<X&> {
         if (o.set) data.construct(o.get());
         return *this;
     }
+
+    void swap(optional& o) noexcept {
+        std::swap(set, o.set);
+        data.swap(o.data);
+    }
 };
 
 /* special case for optional<void>, used as e.g. the result of
@@ -291,14 +461,148 @@ struct optional<void>: detail::optional_base<void> {
     template <typename T>
     optional& operator=(const optional<T>& o) { set=o.set; return *this; }
 
+    void swap(optional& o) noexcept { std::swap(set, o.set); }
+
     // override equality operators
     template <typename Y>
     bool operator==(const Y& y) const { return false; }
+};
 
-    bool operator==(const optional<void>& o) const {
-        return set && o.set || !set && !o.set;
+// Equality of optionals is defined by non-member functions, so that
+// the C++20 rewritten (reversed) forms are not ambiguous with them.
+namespace detail {
+    // An optional<void> is never equal to an optional of another type.
+    template <typename X, typename Y, bool with_void=std::is_void<X>::value || std::is_void<Y>::value>
+    struct optional_eq {
+        static bool eq(const optional<X>& a, const optional<Y>& b) { return (a && b && *a==*b) || (!a && !b); }
+        static bool ne(const optional<X>& a, const optional<Y>& b) { return bool(a)!=bool(b) || (a && *a!=*b); }
+    };
+
+    template <typename X, typename Y>
+    struct optional_eq<X, Y, true> {
+        static bool eq(const optional<X>&, const optional<Y>&) { return false; }
+        static bool ne(const optional<X>&, const optional<Y>&) { return true; }
+    };
+} // namespace detail
+
+template <typename X, typename Y>
+bool operator==(const optional<X>& a, const optional<Y>& b) { return detail::optional_eq<X, Y>::eq(a, b); }
+
+inline bool operator==(const optional<void>& a, const optional<void>& b) {
+    return bool(a)==bool(b);
+}
+
+namespace detail {
+    // Payload of an optional of arithmetic or enum type, read regardless
+    // of the presence flag; zero if unset (see `optional_zeroed`).
+    template <typename X>
+    X optional_raw_value(const optional<X>& o) {
+        static_assert(optional_zeroed<X>::value, "optional_raw_value requires an arithmetic or enum type");
+        X x;
+        std::memcpy(&x, o.operator->(), sizeof(X));
+        return x;
     }
-};
+
+    // Ordering of optionals, with unset values ordered least. For
+    // arithmetic payloads, the terms are combined with bitwise rather
+    // than short-circuiting operators; an optional<void> compared with
+    // another optional is ordered by presence alone.
+    enum optional_compare_kind { compare_generic, compare_arithmetic, compare_presence };
+
+    template <
+        typename X, typename Y,
+        optional_compare_kind kind=
+            std::is_void<X>::value || std::is_void<Y>::value? compare_presence:
+            std::is_arithmetic<X>::value && std::is_arithmetic<Y>::value? compare_arithmetic:
+            compare_generic
+    >
+    struct optional_compare {
+        static bool ne(const optional<X>& a, const optional<Y>& b) { return optional_eq<X, Y>::ne(a, b); }
+        static bool lt(const optional<X>& a, const optional<Y>& b) { return b && (!a || *a<*b); }
+        static bool le(const optional<X>& a, const optional<Y>& b) { return !a || (b && *a<=*b); }
+        static bool gt(const optional<X>& a, const optional<Y>& b) { return a && (!b || *a>*b); }
+        static bool ge(const optional<X>& a, const optional<Y>& b) { return !b || (a && *a>=*b); }
+    };
+
+    template <typename X, typename Y>
+    struct optional_compare<X, Y, compare_presence> {
+        static bool ne(const optional<X>& a, const optional<Y>& b) { return optional_eq<X, Y>::ne(a, b); }
+        static bool lt(const optional<X>& a, const optional<Y>& b) { return bool(a)<bool(b); }
+        static bool le(const optional<X>& a, const optional<Y>& b) { return bool(a)<=bool(b); }
+        static bool gt(const optional<X>& a, const optional<Y>& b) { return bool(a)>bool(b); }
+        static bool ge(const optional<X>& a, const optional<Y>& b) { return bool(a)>=bool(b); }
+    };
+
+    template <typename X, typename Y>
+    struct optional_compare<X, Y, compare_arithmetic> {
+        static bool ne(const optional<X>& a, const optional<Y>& b) {
+            bool sa=bool(a), sb=bool(b);
+            return (sa!=sb) | (sa & sb & (optional_raw_value(a)!=optional_raw_value(b)));
+        }
+
+        static bool lt(const optional<X>& a, const optional<Y>& b) {
+            bool sa=bool(a), sb=bool(b);
+            return (sa<sb) | (sa & sb & (optional_raw_value(a)<optional_raw_value(b)));
+        }
+
+        static bool le(const optional<X>& a, const optional<Y>& b) {
+            bool sa=bool(a), sb=bool(b);
+            return (!sa) | (sb & (optional_raw_value(a)<=optional_raw_value(b)));
+        }
+
+        static bool gt(const optional<X>& a, const optional<Y>& b) {
+            bool sa=bool(a), sb=bool(b);
+            return sa & ((!sb) | (optional_raw_value(a)>optional_raw_value(b)));
+        }
+
+        static bool ge(const optional<X>& a, const optional<Y>& b) {
+            bool sa=bool(a), sb=bool(b);
+            return (!sb) | (sa & (optional_raw_value(a)>=optional_raw_value(b)));
+        }
+    };
+} // namespace detail
+
+template <typename X, typename Y>
+bool operator!=(const optional<X>& a, const optional<Y>& b) { return detail::optional_compare<X, Y>::ne(a, b); }
+
+template <typename X, typename Y>
+bool operator<(const optional<X>& a, const optional<Y>& b) { return detail::optional_compare<X, Y>::lt(a, b); }
+
+template <typename X, typename Y>
+bool operator<=(const optional<X>& a, const optional<Y>& b) { return detail::optional_compare<X, Y>::le(a, b); }
+
+template <typename X, typename Y>
+bool operator>(const optional<X>& a, const optional<Y>& b) { return detail::optional_compare<X, Y>::gt(a, b); }
+
+template <typename X, typename Y>
+bool operator>=(const optional<X>& a, const optional<Y>& b) { return detail::optional_compare<X, Y>::ge(a, b); }
+
+inline bool operator!=(const optional<void>& a, const optional<void>& b) { return bool(a)!=bool(b); }
+inline bool operator<(const optional<void>& a, const optional<void>& b) { return bool(a)<bool(b); }
+inline bool operator<=(const optional<void>& a, const optional<void>& b) { return bool(a)<=bool(b); }
+inline bool operator>(const optional<void>& a, const optional<void>& b) { return bool(a)>bool(b); }
+inline bool operator>=(const optional<void>& a, const optional<void>& b) { return bool(a)>=bool(b); }
+
+#if defined(__cpp_impl_three_way_comparison) && defined(__cpp_lib_three_way_comparison)
+template <typename X, typename Y>
+std::compare_three_way_result_t<X, Y> operator<=>(const optional<X>& a, const optional<Y>& b) {
+    if (a && b) return *a<=>*b;
+    return bool(a)<=>bool(b);
+}
+
+inline std::strong_ordering operator<=>(const optional<void>& a, const optional<void>& b) {
+    return bool(a)<=>bool(b);
+}
+#endif
+
+// Unsigned key with the same order as the optional values, unset
+// least, for radix sorting optionals of integral types narrower than
+// 64 bits.
+template <typename X, typename =typename std::enable_if<std::is_integral<X>::value && (sizeof(X)<8)>::type>
+std::uint64_t radix_key(const optional<X>& o) {
+    std::uint64_t biased=std::int64_t(detail::optional_raw_value(o))-std::int64_t(std::numeric_limits<X>::min());
+    return (biased+1) & -std::uint64_t(bool(o));
+}
 
 
 template <typename A, typename B>
@@ -307,7 +611,8 @@ typename std::enable_if<
     optional<typename std::common_type<typename detail::wrapped_type<A>::type, typename detail::wrapped_type<B>::type>::type>
 >::type
 operator|(A&& a, B&& b) {
-    return a? a: b;
+    typedef optional<typename std::common_type<typename detail::wrapped_type<A>::type, typename detail::wrapped_type<B>::type>::type> result_type;
+    return a? result_type(std::forward<A>(a)): result_type(std::forward<B>(b));
 }
 
 template <typename A, typename B>
@@ -317,16 +622,141 @@ typename std::enable_if<
 >::type
 operator&(A&& a, B&& b) {
     typedef optional<typename detail::wrapped_type<B>::type> result_type;
-    return a? b: result_type{};
+    return a? result_type(std::forward<B>(b)): result_type{};
 }
 
+template <typename X>
+struct is_trivially_relocatable<optional<X>>: is_trivially_relocatable<X> {};
+
+template <>
+struct is_trivially_relocatable<optional<void>>: std::true_type {};
+
+template <typename X>
+void swap(optional<X>& a, optional<X>& b) noexcept(noexcept(a.swap(b))) { a.swap(b); }
+
 inline optional<void> provided(bool condition) { return condition? optional<void>(true): optional<void>(); }
 
 template <typename X>
 optional<X> just(X&& x) { return optional<X>(std::forward<X>(x)); }
 
+namespace detail {
+    template <typename... O>
+    struct all_optional: std::true_type {};
+
+    template <typename O, typename... Os>
+    struct all_optional<O, Os...>: std::integral_constant<bool, is_optional<O>::value && all_optional<Os...>::value> {};
+
+    // Presence flags are combined with `&` rather than `&&`, so that
+    // they are tested together rather than one branch at a time.
+    inline bool all_set() { return true; }
+
+    template <typename O, typename... Os>
+    bool all_set(const O& o, const Os&... os) { return bool(o) & all_set(os...); }
+
+    // Value of an optional argument, moved from if the optional is an
+    // rvalue holding a value rather than a reference.
+    template <typename X>
+    X& optional_forward(optional<X>& o) { return *o; }
+
+    template <typename X>
+    const X& optional_forward(const optional<X>& o) { return *o; }
+
+    template <typename X>
+    X&& optional_forward(optional<X>&& o) { return std::move(*o); }
+
+    template <typename X>
+    X& optional_forward(optional<X&>&& o) { return *o; }
+
+    template <typename R, typename F_result_type>
+    struct apply_impl {
+        template <typename F, typename... A>
+        static R apply(F&& f, A&&... a) { return R(std::forward<F>(f)(std::forward<A>(a)...)); }
+    };
+
+    template <typename R>
+    struct apply_impl<R, void> {
+        template <typename F, typename... A>
+        static R apply(F&& f, A&&... a) { std::forward<F>(f)(std::forward<A>(a)...); return R(true); }
+    };
+
+    template <typename R>
+    struct apply_impl<R, R> {
+        template <typename F, typename... A>
+        static R apply(F&& f, A&&... a) { return std::forward<F>(f)(std::forward<A>(a)...); }
+    };
+
+    template <typename F, typename... O>
+    using optional_apply_result_t=decltype(std::declval<F>()(optional_forward(std::declval<O>())...));
+} // namespace detail
+
+// Multi-argument bind: if every optional argument is set, the result of
+// `f` applied to their values, lifted as by `bind`; otherwise unset.
+// Values are moved from rvalue arguments. Call as `hf::apply` where
+// `std::apply` may also be found by argument-dependent lookup.
+template <typename F, typename... O, typename =typename std::enable_if<detail::all_optional<O...>::value>::type>
+typename detail::lift_type<detail::optional_apply_result_t<F, O&&...>>::type
+apply(F&& f, O&&... o) {
+    typedef detail::optional_apply_result_t<F, O&&...> F_result_type;
+    typedef typename detail::lift_type<F_result_type>::type result_type;
+
+    if (!detail::all_set(o...)) return result_type();
+    return detail::apply_impl<result_type, F_result_type>::apply(std::forward<F>(f), detail::optional_forward(std::forward<O>(o))...);
+}
+
+namespace detail {
+    struct lift_tag {};
+
+    // Overloads of `lifted_call` for other argument types (see either.h)
+    // are found by argument-dependent lookup on `lift_tag`.
+    template <typename F, typename... O, typename =typename std::enable_if<all_optional<O...>::value>::type>
+    auto lifted_call(const lift_tag&, F& f, O&&... o) -> decltype(hf::apply(f, std::forward<O>(o)...)) {
+        return hf::apply(f, std::forward<O>(o)...);
+    }
+
+    template <typename F>
+    struct lifted {
+        F f;
+
+        template <typename... O>
+        auto operator()(O&&... o) -> decltype(lifted_call(lift_tag{}, f, std::forward<O>(o)...)) {
+            return lifted_call(lift_tag{}, f, std::forward<O>(o)...);
+        }
+
+        template <typename... O>
+        auto operator()(O&&... o) const -> decltype(lifted_call(lift_tag{}, f, std::forward<O>(o)...)) {
+            return lifted_call(lift_tag{}, f, std::forward<O>(o)...);
+        }
+    };
+} // namespace detail
+
+// `lift(f)(args...)` is `apply(f, args...)`.
+template <typename F>
+detail::lifted<typename std::decay<F>::type> lift(F&& f) { return {std::forward<F>(f)}; }
+
 } // namespace hf
 
+namespace std {
+
+template <typename X, typename Alloc>
+struct uses_allocator<hf::optional<X>, Alloc>: uses_allocator<X, Alloc> {};
+
+#if defined(__cpp_lib_ranges)
+namespace ranges {
+
+// As for `std::optional` in C++26, an optional is a view of zero or one
+// elements; iterators into an optional reference do not depend on the
+// lifetime of the optional itself.
+template <typename X>
+constexpr bool enable_view<hf::optional<X>> = true;
+
+template <typename X>
+constexpr bool enable_borrowed_range<hf::optional<X&>> = true;
+
+} // namespace ranges
+#endif
+
+} // namespace std
+
 #pragma clang diagnostic pop
 
 #endif // ndef HF_OPTIONALM_H_
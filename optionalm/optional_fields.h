@@ -0,0 +1,244 @@
+#ifndef HF_OPTIONAL_FIELDS_H_
+#define HF_OPTIONAL_FIELDS_H_
+
+/* Record of optional fields sharing one presence mask.
+ *
+ * `optional_fields<T0, T1, ...>` holds up to 64 optional values, like
+ * a struct of `optional<T0>`, `optional<T1>`, ... members, but keeps
+ * the presence flags together as bits of a single unsigned word rather
+ * than a `bool` (plus padding) per field.
+ *
+ * Field `I` is read through `get<I>()`, which returns an `optional<T&>`
+ * referring to the stored value, and written with `set<I>(value)` or
+ * `emplace<I>(args...)`. The presence of all fields can be queried at
+ * once with `count()`, `has_any()`, `has_all(mask)` and `presence()`,
+ * and cleared with `reset()`.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/bits.h>
+#include <optionalm/optional.h>
+#include <optionalm/uninitialized.h>
+
+namespace hf {
+
+namespace detail {
+    // Smallest unsigned type with at least N bits.
+    template <std::size_t N>
+    struct field_mask_type {
+        static_assert(N<=64, "optional_fields supports at most 64 fields");
+
+        typedef typename std::conditional<(N<=8), std::uint8_t,
+                typename std::conditional<(N<=16), std::uint16_t,
+                typename std::conditional<(N<=32), std::uint32_t, std::uint64_t>::type>::type>::type type;
+    };
+
+    // Storage for fields I, I+1, ...; each operation acts on the slots
+    // whose bits are set in the supplied masks, and keeps the mask `m`
+    // of constructed fields up to date so that it remains valid if a
+    // constructor or assignment throws.
+    template <std::size_t I, typename... Ts>
+    struct field_slots {
+        template <typename M> void destroy(M) {}
+        template <typename M> void copy_construct(const field_slots&, M, M&) {}
+        template <typename M> void move_construct(field_slots&, M, M&) {}
+        template <typename M> void copy_assign(const field_slots&, M, M&) {}
+        template <typename M> void move_assign(field_slots&, M, M&) {}
+    };
+
+    template <std::size_t I, typename T, typename... Ts>
+    struct field_slots<I, T, Ts...>: field_slots<I+1, Ts...> {
+        static_assert(!std::is_reference<T>::value, "optional_fields fields must be value types");
+
+        typedef field_slots<I+1, Ts...> next;
+        uninitialized<T> slot;
+
+        template <typename M>
+        static constexpr M bit() { return M(1)<<I; }
+
+        template <typename M>
+        void destroy(M m) {
+            if (m & bit<M>()) slot.destruct();
+            next::destroy(m);
+        }
+
+        template <typename M>
+        void copy_construct(const field_slots& x, M from, M& m) {
+            if (from & bit<M>()) {
+                slot.construct(x.slot.cref());
+                m |= bit<M>();
+            }
+            next::copy_construct(x, from, m);
+        }
+
+        template <typename M>
+        void move_construct(field_slots& x, M from, M& m) {
+            if (from & bit<M>()) {
+                slot.construct(std::move(x.slot.ref()));
+                m |= bit<M>();
+            }
+            next::move_construct(x, from, m);
+        }
+
+        template <typename M>
+        void copy_assign(const field_slots& x, M from, M& m) {
+            if (from & bit<M>()) {
+                if (m & bit<M>()) slot.assign(x.slot.cref());
+                else {
+                    slot.construct(x.slot.cref());
+                    m |= bit<M>();
+                }
+            }
+            else if (m & bit<M>()) {
+                slot.destruct();
+                m &= ~bit<M>();
+            }
+            next::copy_assign(x, from, m);
+        }
+
+        template <typename M>
+        void move_assign(field_slots& x, M from, M& m) {
+            if (from & bit<M>()) {
+                if (m & bit<M>()) slot.assign(std::move(x.slot.ref()));
+                else {
+                    slot.construct(std::move(x.slot.ref()));
+                    m |= bit<M>();
+                }
+            }
+            else if (m & bit<M>()) {
+                slot.destruct();
+                m &= ~bit<M>();
+            }
+            next::move_assign(x, from, m);
+        }
+    };
+
+    // Slot of field I, found by conversion to the unique base with that index.
+    template <std::size_t I, typename T, typename... Ts>
+    uninitialized<T>& field_slot(field_slots<I, T, Ts...>& s) { return s.slot; }
+
+    template <std::size_t I, typename T, typename... Ts>
+    const uninitialized<T>& field_slot(const field_slots<I, T, Ts...>& s) { return s.slot; }
+
+    template <std::size_t I, typename... Ts>
+    struct field_type;
+
+    template <typename T, typename... Ts>
+    struct field_type<0, T, Ts...> { typedef T type; };
+
+    template <std::size_t I, typename T, typename... Ts>
+    struct field_type<I, T, Ts...>: field_type<I-1, Ts...> {};
+} // namespace detail
+
+template <typename... Ts>
+class optional_fields {
+public:
+    typedef typename detail::field_mask_type<sizeof...(Ts)>::type mask_type;
+
+    template <std::size_t I>
+    using field_type=typename detail::field_type<I, Ts...>::type;
+
+    static constexpr std::size_t size() { return sizeof...(Ts); }
+
+    // Bit in the presence mask corresponding to field I.
+    template <std::size_t I>
+    static constexpr mask_type bit() { return mask_type(1)<<I; }
+
+    optional_fields() noexcept: mask(0) {}
+
+    optional_fields(const optional_fields& x): mask(0) {
+        try {
+            slots.copy_construct(x.slots, x.mask, mask);
+        }
+        catch (...) {
+            reset();
+            throw;
+        }
+    }
+
+    optional_fields(optional_fields&& x): mask(0) {
+        try {
+            slots.move_construct(x.slots, x.mask, mask);
+        }
+        catch (...) {
+            reset();
+            throw;
+        }
+    }
+
+    optional_fields& operator=(const optional_fields& x) {
+        if (this!=&x) slots.copy_assign(x.slots, x.mask, mask);
+        return *this;
+    }
+
+    optional_fields& operator=(optional_fields&& x) {
+        if (this!=&x) slots.move_assign(x.slots, x.mask, mask);
+        return *this;
+    }
+
+    ~optional_fields() { slots.destroy(mask); }
+
+    // Per-field access.
+    template <std::size_t I>
+    bool has() const { return mask & bit<I>(); }
+
+    template <std::size_t I>
+    optional<field_type<I>&> get() {
+        return has<I>()? optional<field_type<I>&>(detail::field_slot<I>(slots).ref()): optional<field_type<I>&>();
+    }
+
+    template <std::size_t I>
+    optional<const field_type<I>&> get() const {
+        return has<I>()? optional<const field_type<I>&>(detail::field_slot<I>(slots).cref()): optional<const field_type<I>&>();
+    }
+
+    template <std::size_t I, typename... Args>
+    field_type<I>& emplace(Args&&... args) {
+        reset<I>();
+        detail::field_slot<I>(slots).construct(std::forward<Args>(args)...);
+        mask |= bit<I>();
+        return detail::field_slot<I>(slots).ref();
+    }
+
+    // Assign to the field if present, else construct it.
+    template <std::size_t I, typename U>
+    field_type<I>& set(U&& value) {
+        if (has<I>()) {
+            detail::field_slot<I>(slots).ref()=std::forward<U>(value);
+            return detail::field_slot<I>(slots).ref();
+        }
+        return emplace<I>(std::forward<U>(value));
+    }
+
+    template <std::size_t I>
+    void reset() {
+        if (has<I>()) {
+            detail::field_slot<I>(slots).destruct();
+            mask &= ~bit<I>();
+        }
+    }
+
+    // Bulk queries and reset.
+    mask_type presence() const { return mask; }
+    std::size_t count() const { return detail::popcount(mask); }
+    bool has_any() const { return mask!=0; }
+    bool has_any(mask_type m) const { return (mask & m)!=0; }
+    bool has_all(mask_type m) const { return (mask & m)==m; }
+
+    void reset() {
+        slots.destroy(mask);
+        mask=0;
+    }
+
+private:
+    detail::field_slots<0, Ts...> slots;
+    mask_type mask;
+};
+
+} // namespace hf
+
+#endif // ndef HF_OPTIONAL_FIELDS_H_
@@ -0,0 +1,242 @@
+#ifndef HF_PACKED_OPTIONAL_H_
+#define HF_PACKED_OPTIONAL_H_
+
+/* Bit-packed sequence of optional values drawn from a small set.
+ *
+ * `packed_optional_vector<T, N>` stores a sequence of `optional<T>`
+ * where `T` is `bool`, or an enum or integral type taking the values
+ * 0 to N-1. Each element is encoded in ⌈log2(N+1)⌉ bits as zero if
+ * unset, or one plus its value: two bits for `optional<bool>`. Storing
+ * a value outside this range throws `std::out_of_range`.
+ *
+ * Codes are held in bit planes: each group of 64 elements occupies
+ * one word per code bit, holding that bit for every element of the
+ * group. Counting and element-wise logical operations then act on
+ * whole words at a time, in loops without data-dependent branches.
+ *
+ * For `bool`, the planes are the is-false and is-true masks, and
+ * `kleene_and`, `kleene_or` and `kleene_not` give the element-wise
+ * three-valued logic operations, with unset as unknown.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <optionalm/bits.h>
+#include <optionalm/optional.h>
+
+namespace hf {
+
+namespace detail {
+    // Number of bits needed to represent codes 0 to n.
+    constexpr unsigned code_bits(std::size_t n, unsigned b=0) {
+        return (std::size_t(1)<<b)>n? b: code_bits(n, b+1);
+    }
+
+    // Codes of B bits stored in bit planes; bits past the end of the
+    // sequence are kept zero.
+    template <unsigned B>
+    class bit_planes {
+        std::vector<std::uint64_t> words_;
+        std::size_t size_=0;
+
+    public:
+        std::size_t size() const { return size_; }
+        std::size_t groups() const { return words_.size()/B; }
+
+        const std::uint64_t* group(std::size_t g) const { return words_.data()+g*B; }
+        std::uint64_t* group(std::size_t g) { return words_.data()+g*B; }
+
+        // Mask of the elements of group g that are within the sequence.
+        std::uint64_t valid(std::size_t g) const {
+            std::size_t rem=size_-64*g;
+            return rem>=64? ~std::uint64_t(0): (std::uint64_t(1)<<rem)-1;
+        }
+
+        void resize(std::size_t n) {
+            words_.resize(B*((n+63)/64));
+            size_=n;
+            if (n%64) {
+                std::uint64_t* w=group(n/64);
+                for (unsigned p=0; p<B; ++p) w[p] &= valid(n/64);
+            }
+        }
+
+        void reserve(std::size_t n) { words_.reserve(B*((n+63)/64)); }
+
+        unsigned code(std::size_t i) const {
+            const std::uint64_t* w=group(i/64);
+            unsigned shift=i%64, c=0;
+            for (unsigned p=0; p<B; ++p) c |= unsigned(w[p]>>shift & 1)<<p;
+            return c;
+        }
+
+        void set_code(std::size_t i, unsigned c) {
+            std::uint64_t* w=group(i/64);
+            unsigned shift=i%64;
+            for (unsigned p=0; p<B; ++p) {
+                w[p] = (w[p] & ~(std::uint64_t(1)<<shift)) | std::uint64_t(c>>p & 1)<<shift;
+            }
+        }
+    };
+} // namespace detail
+
+template <typename T, std::size_t N=std::is_same<T, bool>::value? 2: 0>
+class packed_optional_vector {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+        "packed_optional_vector values must be of integral or enum type");
+    static_assert(N>0, "number of values N must be given for non-bool types");
+
+public:
+    static constexpr unsigned bits=detail::code_bits(N);
+
+private:
+    detail::bit_planes<bits> planes_;
+
+    static bool in_range(T x) { return (unsigned long long)x<N; }
+
+    static unsigned encode(const optional<T>& x) {
+        if (!x) return 0;
+        if (!in_range(*x)) throw std::out_of_range("packed_optional_vector value out of range");
+        return unsigned(*x)+1;
+    }
+    static optional<T> decode(unsigned c) { return c? optional<T>(T(c-1)): optional<T>(); }
+
+public:
+    typedef optional<T> value_type;
+    typedef optional<T> const_reference;
+    typedef std::size_t size_type;
+
+    // Proxy for an element, convertible to and assignable from `optional<T>`.
+    class reference {
+        packed_optional_vector* v_;
+        size_type i_;
+
+        friend class packed_optional_vector;
+        reference(packed_optional_vector* v, size_type i): v_(v), i_(i) {}
+
+    public:
+        operator optional<T>() const { return v_->get(i_); }
+
+        reference& operator=(const optional<T>& x) {
+            v_->set(i_, x);
+            return *this;
+        }
+
+        reference& operator=(const reference& r) { return *this=optional<T>(r); }
+    };
+
+    packed_optional_vector() {}
+    explicit packed_optional_vector(size_type n) { resize(n); }
+
+    size_type size() const { return planes_.size(); }
+    bool empty() const { return size()==0; }
+
+    // New elements are unset.
+    void resize(size_type n) { planes_.resize(n); }
+    void reserve(size_type n) { planes_.reserve(n); }
+    void clear() { planes_.resize(0); }
+
+    optional<T> get(size_type i) const { return decode(planes_.code(i)); }
+    void set(size_type i, const optional<T>& x) { planes_.set_code(i, encode(x)); }
+
+    const_reference operator[](size_type i) const { return get(i); }
+    reference operator[](size_type i) { return reference(this, i); }
+
+    void push_back(const optional<T>& x) {
+        unsigned c=encode(x);
+        planes_.resize(size()+1);
+        planes_.set_code(size()-1, c);
+    }
+
+    // Number of set elements.
+    size_type count_set() const {
+        size_type n=0;
+        for (std::size_t g=0; g<planes_.groups(); ++g) {
+            const std::uint64_t* w=planes_.group(g);
+            std::uint64_t any=0;
+            for (unsigned p=0; p<bits; ++p) any |= w[p];
+            n += detail::popcount(any);
+        }
+        return n;
+    }
+
+    // Number of elements set to `x`.
+    size_type count(T x) const {
+        if (!in_range(x)) return 0;
+
+        unsigned c=unsigned(x)+1;
+        size_type n=0;
+        for (std::size_t g=0; g<planes_.groups(); ++g) {
+            const std::uint64_t* w=planes_.group(g);
+            std::uint64_t match=planes_.valid(g);
+            for (unsigned p=0; p<bits; ++p) match &= (c>>p & 1)? w[p]: ~w[p];
+            n += detail::popcount(match);
+        }
+        return n;
+    }
+
+    // Word-level access to the bit planes: word p of group g holds
+    // code bit p of elements 64g to 64g+63.
+    std::size_t groups() const { return planes_.groups(); }
+    const std::uint64_t* group(std::size_t g) const { return planes_.group(g); }
+    std::uint64_t* group(std::size_t g) { return planes_.group(g); }
+};
+
+template <typename T, std::size_t N>
+constexpr unsigned packed_optional_vector<T, N>::bits;
+
+namespace detail {
+    // Apply `f(false_a, true_a, false_b, true_b, false_out, true_out)`
+    // to each group of planes of two sequences of optional<bool>.
+    template <typename F>
+    packed_optional_vector<bool> kleene_combine(const packed_optional_vector<bool>& a, const packed_optional_vector<bool>& b, F f) {
+        if (a.size()!=b.size()) throw std::invalid_argument("mismatched sequence sizes");
+
+        packed_optional_vector<bool> r(a.size());
+        for (std::size_t g=0; g<r.groups(); ++g) {
+            const std::uint64_t* wa=a.group(g);
+            const std::uint64_t* wb=b.group(g);
+            std::uint64_t* wr=r.group(g);
+            f(wa[0], wa[1], wb[0], wb[1], wr[0], wr[1]);
+        }
+        return r;
+    }
+} // namespace detail
+
+// Element-wise Kleene conjunction: false if either is false, else
+// unset if either is unset.
+inline packed_optional_vector<bool> kleene_and(const packed_optional_vector<bool>& a, const packed_optional_vector<bool>& b) {
+    return detail::kleene_combine(a, b,
+        [](std::uint64_t fa, std::uint64_t ta, std::uint64_t fb, std::uint64_t tb, std::uint64_t& f, std::uint64_t& t) {
+            f = fa | fb;
+            t = ta & tb;
+        });
+}
+
+// Element-wise Kleene disjunction: true if either is true, else unset
+// if either is unset.
+inline packed_optional_vector<bool> kleene_or(const packed_optional_vector<bool>& a, const packed_optional_vector<bool>& b) {
+    return detail::kleene_combine(a, b,
+        [](std::uint64_t fa, std::uint64_t ta, std::uint64_t fb, std::uint64_t tb, std::uint64_t& f, std::uint64_t& t) {
+            f = fa & fb;
+            t = ta | tb;
+        });
+}
+
+// Element-wise negation; unset elements remain unset.
+inline packed_optional_vector<bool> kleene_not(const packed_optional_vector<bool>& a) {
+    packed_optional_vector<bool> r(a.size());
+    for (std::size_t g=0; g<r.groups(); ++g) {
+        r.group(g)[0] = a.group(g)[1];
+        r.group(g)[1] = a.group(g)[0];
+    }
+    return r;
+}
+
+} // namespace hf
+
+#endif // ndef HF_PACKED_OPTIONAL_H_
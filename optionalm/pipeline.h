@@ -0,0 +1,265 @@
+#ifndef HF_PIPELINE_H_
+#define HF_PIPELINE_H_
+
+/* Multi-stage processing of a sequence of values on worker threads.
+ *
+ * `run_pipeline(first, last, out, options, f1, f2, ..., fn)` applies
+ * the stages `f1` through `fn` in turn to each value in [first, last),
+ * writing the results of the last stage to `out`. Each stage has the
+ * semantics of `optional<X>::bind`: a stage returning `optional<Y>`
+ * may discard a value by returning an unset optional, while a stage
+ * returning a plain `Y` always passes its result on.
+ *
+ * Each stage runs on its own worker threads: stage `i` (counting from
+ * zero) on `options.stage_workers[i]` threads, or `options.workers` if
+ * `stage_workers` has no entry for it, so that more threads can be
+ * given to costlier stages. Values are passed between stages in
+ * batches of up to `options.batch_size`
+ * through bounded queues holding at most `options.queue_capacity`
+ * batches. Discarded values are dropped before batching, and so take
+ * no space downstream. The output is written from the calling thread.
+ *
+ * With one worker per stage, the output preserves the input order;
+ * with more, the order is unspecified and each stage functor may be
+ * called concurrently.
+ *
+ * An exception thrown by a stage, by the input iteration or by the
+ * output iterator, or raised in starting a worker thread, stops further
+ * processing, and is rethrown from `run_pipeline` once all threads
+ * have finished.
+ */
+
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <optionalm/optional.h>
+
+namespace hf {
+
+struct pipeline_options {
+    std::size_t batch_size=256;
+    std::size_t queue_capacity=4;
+    unsigned workers=1;
+    std::vector<unsigned> stage_workers;
+
+    unsigned workers_for(std::size_t stage) const {
+        unsigned n=stage<stage_workers.size()? stage_workers[stage]: workers;
+        return n? n: 1;
+    }
+};
+
+namespace detail {
+    // Bounded blocking queue of batches; `pop` returns an unset value
+    // once the queue has been closed and drained.
+    template <typename X>
+    class batch_queue {
+        std::mutex mutex;
+        std::condition_variable not_empty, not_full;
+        std::deque<std::vector<X>> batches;
+        std::size_t capacity;
+        unsigned producers;
+
+    public:
+        batch_queue(std::size_t capacity_, unsigned producers_):
+            capacity(capacity_? capacity_: 1), producers(producers_) {}
+
+        void push(std::vector<X>&& batch) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this]() { return batches.size()<capacity; });
+            batches.push_back(std::move(batch));
+            not_empty.notify_one();
+        }
+
+        optional<std::vector<X>> pop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this]() { return !batches.empty() || !producers; });
+            if (batches.empty()) return nothing;
+
+            optional<std::vector<X>> batch(std::move(batches.front()));
+            batches.pop_front();
+            not_full.notify_one();
+            return batch;
+        }
+
+        // Called by each producer when it has finished.
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (producers && !--producers) not_empty.notify_all();
+        }
+    };
+
+    struct pipeline_state {
+        std::mutex mutex;
+        std::exception_ptr error;
+        bool failed=false;
+
+        void fail() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failed) error=std::current_exception();
+            failed=true;
+        }
+
+        bool ok() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !failed;
+        }
+    };
+
+    // Collects values into batches of a given size for a batch_queue.
+    // The last batch should be flushed explicitly; one left pending is
+    // flushed on destruction, and a failure to do so fails the pipeline.
+    template <typename X>
+    class batcher {
+        batch_queue<X>& queue;
+        pipeline_state& state;
+        std::size_t batch_size;
+        std::vector<X> pending;
+
+    public:
+        batcher(batch_queue<X>& q, pipeline_state& s, std::size_t n): queue(q), state(s), batch_size(n? n: 1) {
+            pending.reserve(batch_size);
+        }
+
+        template <typename Y>
+        void push(Y&& y) {
+            pending.push_back(std::forward<Y>(y));
+            if (pending.size()>=batch_size) flush();
+        }
+
+        void flush() {
+            if (pending.empty()) return;
+            queue.push(std::move(pending));
+            pending.clear();
+            pending.reserve(batch_size);
+        }
+
+        ~batcher() {
+            try {
+                flush();
+            }
+            catch (...) {
+                state.fail();
+            }
+            queue.close();
+        }
+    };
+
+    template <typename X, typename... F>
+    struct pipeline_stages;
+
+    // Final stage: drain the last queue into the output iterator.
+    template <typename X>
+    struct pipeline_stages<X> {
+        template <typename OutputIt>
+        static OutputIt run(batch_queue<X>& in, OutputIt out, const pipeline_options&, pipeline_state& state, std::size_t) {
+            while (auto batch=in.pop()) {
+                if (!state.ok()) continue;
+                try {
+                    for (auto& x: *batch) *out++ = std::move(x);
+                }
+                catch (...) {
+                    state.fail();
+                }
+            }
+            return out;
+        }
+    };
+
+    template <typename X, typename F, typename... Rest>
+    struct pipeline_stages<X, F, Rest...> {
+        typedef typename std::result_of<F&(X&&)>::type F_result_type;
+        typedef typename lift_type<F_result_type>::type result_type;
+        typedef typename wrapped_type<result_type>::type Y;
+
+        static_assert(!std::is_void<Y>::value && !std::is_reference<Y>::value,
+            "pipeline stages must return values");
+
+        static void work(batch_queue<X>& in, batch_queue<Y>& next, const pipeline_options& opt, pipeline_state& state, F& f) {
+            batcher<Y> out(next, state, opt.batch_size);
+            while (auto batch=in.pop()) {
+                if (!state.ok()) continue;
+                try {
+                    for (auto& x: *batch) {
+                        result_type r(f(std::move(x)));
+                        if (r) out.push(std::move(*r));
+                    }
+                }
+                catch (...) {
+                    state.fail();
+                }
+            }
+
+            try {
+                if (state.ok()) out.flush();
+            }
+            catch (...) {
+                state.fail();
+            }
+        }
+
+        template <typename OutputIt>
+        static OutputIt run(batch_queue<X>& in, OutputIt out, const pipeline_options& opt, pipeline_state& state, std::size_t stage,
+            F& f, Rest&... rest)
+        {
+            unsigned n_workers=opt.workers_for(stage);
+            batch_queue<Y> next(opt.queue_capacity, n_workers);
+
+            std::vector<std::thread> workers;
+            try {
+                workers.reserve(n_workers);
+                for (unsigned i=0; i<n_workers; ++i) {
+                    workers.emplace_back(work, std::ref(in), std::ref(next), std::cref(opt), std::ref(state), std::ref(f));
+                }
+            }
+            catch (...) {
+                // Stop the pipeline, and stand in for the workers that
+                // did not start: drain the input if none did, and close
+                // the output for each. The remaining stages then drain
+                // their queues as usual.
+                state.fail();
+                if (workers.empty()) while (in.pop()) {}
+                for (std::size_t i=workers.size(); i<n_workers; ++i) next.close();
+            }
+
+            out=pipeline_stages<Y, Rest...>::run(next, out, opt, state, stage+1, rest...);
+            for (auto& w: workers) w.join();
+            return out;
+        }
+    };
+} // namespace detail
+
+template <typename InputIt, typename OutputIt, typename... F>
+OutputIt run_pipeline(InputIt first, InputIt last, OutputIt out, const pipeline_options& opt, F... stages) {
+    typedef typename std::decay<decltype(*first)>::type X;
+
+    detail::pipeline_state state;
+    detail::batch_queue<X> input(opt.queue_capacity, 1);
+
+    std::thread feeder([&]() {
+        detail::batcher<X> batches(input, state, opt.batch_size);
+        try {
+            for (; first!=last && state.ok(); ++first) batches.push(*first);
+            if (state.ok()) batches.flush();
+        }
+        catch (...) {
+            state.fail();
+        }
+    });
+
+    out=detail::pipeline_stages<X, F...>::run(input, out, opt, state, 0, stages...);
+    feeder.join();
+
+    if (state.error) std::rethrow_exception(state.error);
+    return out;
+}
+
+} // namespace hf
+
+#endif // ndef HF_PIPELINE_H_
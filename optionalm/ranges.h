@@ -0,0 +1,176 @@
+#ifndef HF_RANGES_H_
+#define HF_RANGES_H_
+
+/* Lazy views over ranges of optional and either values.
+ *
+ * `flatten(r)` is a view of the values held by the set optionals in
+ * the range `r`, in order: each `optional<X>` is treated as a range of
+ * zero or one elements (see `optional<X>::begin()`), and the view is
+ * their concatenation. `lefts(r)` and `rights(r)` are the views of
+ * field 0 or field 1 respectively of the eithers in `r` that hold that
+ * field.
+ *
+ * The views hold iterators into `r`, which must outlive them; they are
+ * also available over an iterator pair, as `flatten(first, last)` etc.
+ * When `r` yields references, the views yield references to the held
+ * values, so that no element is copied and values can be modified in
+ * place; when `r` yields prvalues, the views yield values.
+ *
+ * Views are forward ranges if the underlying iterators are forward
+ * iterators, and input ranges otherwise. As with `std::ranges::filter_view`,
+ * `begin()` caches the position of the first element of the view, and
+ * is not available on a const view.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/optional.h>
+#include <optionalm/either.h>
+
+#if __cplusplus>=202002L
+#include <ranges>
+#endif
+
+namespace hf {
+
+namespace detail {
+    // A projection `P` gives by `P::has(x)` whether element `x` of the
+    // underlying range contributes to the view, and by `P::get(x)` the
+    // value it contributes.
+    struct project_set {
+        template <typename O>
+        static bool has(const O& o) { return bool(o); }
+
+        template <typename O>
+        static auto get(O&& o) -> decltype(*std::forward<O>(o)) { return *std::forward<O>(o); }
+    };
+
+    template <std::size_t I>
+    struct project_field {
+        template <typename E>
+        static bool has(const E& e) { return e.index()==I; }
+
+        template <typename E>
+        static auto get(E&& e) -> decltype(e.template unsafe_get<I>()) { return e.template unsafe_get<I>(); }
+    };
+
+    template <typename It, typename P>
+    class project_iterator {
+        typedef decltype(*std::declval<It&>()) base_reference;
+        typedef decltype(P::get(std::declval<base_reference>())) get_result;
+        typedef typename std::iterator_traits<It>::iterator_category base_category;
+
+        It pos_, last_;
+
+        void skip() {
+            while (pos_!=last_ && !P::has(*pos_)) ++pos_;
+        }
+
+    public:
+        // References into a prvalue element would dangle; return a copy.
+        typedef typename std::conditional<std::is_reference<base_reference>::value,
+            get_result, typename std::decay<get_result>::type>::type reference;
+        typedef typename std::decay<get_result>::type value_type;
+        typedef typename std::remove_reference<reference>::type* pointer;
+        typedef typename std::iterator_traits<It>::difference_type difference_type;
+        typedef typename std::conditional<std::is_base_of<std::forward_iterator_tag, base_category>::value,
+            std::forward_iterator_tag, std::input_iterator_tag>::type iterator_category;
+
+        project_iterator() {}
+        project_iterator(It pos, It last): pos_(pos), last_(last) { skip(); }
+
+        It base() const { return pos_; }
+
+        reference operator*() const { return P::get(*pos_); }
+
+        project_iterator& operator++() {
+            ++pos_;
+            skip();
+            return *this;
+        }
+
+        project_iterator operator++(int) {
+            project_iterator i(*this);
+            ++*this;
+            return i;
+        }
+
+        bool operator==(const project_iterator& i) const { return pos_==i.pos_; }
+        bool operator!=(const project_iterator& i) const { return pos_!=i.pos_; }
+    };
+
+    template <typename It, typename P>
+    class project_view {
+        It first_, last_;
+
+        // Position of the first contributing element, found by the
+        // first call to `begin()` (as in `std::ranges::filter_view`).
+        optional<It> begin_;
+
+    public:
+        typedef project_iterator<It, P> iterator;
+
+        project_view() {}
+        project_view(It first, It last): first_(first), last_(last) {}
+
+        // Amortized constant time: only the first call scans for the
+        // first contributing element. As the result is cached, a view
+        // cannot be iterated through a const reference.
+        iterator begin() {
+            if (!begin_) begin_=iterator(first_, last_).base();
+            return iterator(*begin_, last_);
+        }
+
+        iterator end() const { return iterator(last_, last_); }
+
+        bool empty() { return begin()==end(); }
+    };
+
+    template <typename R>
+    using range_iterator_t=decltype(std::begin(std::declval<R&>()));
+} // namespace detail
+
+template <typename It>
+detail::project_view<It, detail::project_set> flatten(It first, It last) { return {first, last}; }
+
+template <typename R>
+detail::project_view<detail::range_iterator_t<R>, detail::project_set> flatten(R& r) {
+    return {std::begin(r), std::end(r)};
+}
+
+template <typename It>
+detail::project_view<It, detail::project_field<0>> lefts(It first, It last) { return {first, last}; }
+
+template <typename R>
+detail::project_view<detail::range_iterator_t<R>, detail::project_field<0>> lefts(R& r) {
+    return {std::begin(r), std::end(r)};
+}
+
+template <typename It>
+detail::project_view<It, detail::project_field<1>> rights(It first, It last) { return {first, last}; }
+
+template <typename R>
+detail::project_view<detail::range_iterator_t<R>, detail::project_field<1>> rights(R& r) {
+    return {std::begin(r), std::end(r)};
+}
+
+} // namespace hf
+
+#if defined(__cpp_lib_ranges)
+namespace std {
+namespace ranges {
+
+template <typename It, typename P>
+constexpr bool enable_view<hf::detail::project_view<It, P>> = true;
+
+template <typename It, typename P>
+constexpr bool enable_borrowed_range<hf::detail::project_view<It, P>> = true;
+
+} // namespace ranges
+} // namespace std
+#endif
+
+#endif // ndef HF_RANGES_H_
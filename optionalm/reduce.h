@@ -0,0 +1,206 @@
+#ifndef HF_REDUCE_H_
+#define HF_REDUCE_H_
+
+/* Reductions over sequences of optional arithmetic values.
+ *
+ * `reduce_sum`, `reduce_count`, `reduce_min`, `reduce_max`,
+ * `reduce_mean` and `reduce_dot` take random access ranges of
+ * `optional<X>` for arithmetic `X` of at most 8 bytes (so not
+ * `long double`) and ignore unset elements.
+ *
+ * The kernels read each payload regardless of its presence flag and
+ * mask its bits, rather than branching on the flag, and accumulate
+ * into several independent partial results, so that floating point
+ * sums are not serialized on a single accumulator. The loops thus
+ * have no data-dependent branches. They are portable scalar code: no
+ * SIMD instructions are used explicitly, and whether any are generated
+ * is up to the compiler.
+ *
+ * Integer sums are accumulated in `long long` or `unsigned long long`.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include <optionalm/optional.h>
+
+namespace hf {
+
+namespace detail {
+    template <typename X, bool integral=std::is_integral<X>::value>
+    struct reduce_acc { typedef X type; };
+
+    template <typename X>
+    struct reduce_acc<X, true> {
+        typedef typename std::conditional<std::is_signed<X>::value, long long, unsigned long long>::type type;
+    };
+
+    template <typename It>
+    struct reduce_value {
+        typedef typename wrapped_type<typename std::iterator_traits<It>::value_type>::type type;
+        static_assert(std::is_arithmetic<type>::value, "reductions require optional arithmetic values");
+        static_assert(sizeof(type)<=8, "reductions support arithmetic values of at most 8 bytes");
+    };
+
+    template <std::size_t n> struct bits_type {};
+    template <> struct bits_type<1> { typedef std::uint8_t type; };
+    template <> struct bits_type<2> { typedef std::uint16_t type; };
+    template <> struct bits_type<4> { typedef std::uint32_t type; };
+    template <> struct bits_type<8> { typedef std::uint64_t type; };
+
+    // `a` if `c` is true, else `b`, selected by masking the bits of
+    // the values rather than branching.
+    template <typename X>
+    X select_bits(bool c, X a, X b) {
+        typedef typename bits_type<sizeof(X)>::type U;
+        U ua, ub, m=U(0)-U(c);
+        std::memcpy(&ua, &a, sizeof(X));
+        std::memcpy(&ub, &b, sizeof(X));
+        ua = (ua & m) | (ub & ~m);
+        std::memcpy(&a, &ua, sizeof(X));
+        return a;
+    }
+
+    // `x` if `keep` is true, else the value with all bits zero.
+    template <typename X>
+    X mask_value(X x, bool keep) {
+        X zero;
+        std::memset(&zero, 0, sizeof(X));
+        return select_bits(keep, x, zero);
+    }
+
+    // Payload of a set optional, or zero if unset.
+    template <typename X>
+    X masked_value(const optional<X>& o) {
+        return mask_value(optional_raw_value(o), bool(o));
+    }
+
+    // Initial values for min and max: infinities where X has them, so
+    // that an infinite element is not replaced by the largest finite value.
+    template <typename X>
+    constexpr X reduce_upper_bound() {
+        return std::numeric_limits<X>::has_infinity? std::numeric_limits<X>::infinity(): std::numeric_limits<X>::max();
+    }
+
+    template <typename X>
+    constexpr X reduce_lower_bound() {
+        return std::numeric_limits<X>::has_infinity? -std::numeric_limits<X>::infinity(): std::numeric_limits<X>::lowest();
+    }
+
+    constexpr std::size_t reduce_lanes=8;
+
+    // Fold `step(acc, element)` over [first, last) into `reduce_lanes`
+    // partial results starting from `init`, then combine these with
+    // `combine(acc, acc)`.
+    template <typename RandomIt, typename Acc, typename Step, typename Combine>
+    Acc lane_reduce(RandomIt first, RandomIt last, Acc init, Step step, Combine combine) {
+        Acc part[reduce_lanes];
+        for (auto& p: part) p=init;
+
+        std::size_t n=std::distance(first, last);
+        for (; n>=reduce_lanes; n-=reduce_lanes, first+=reduce_lanes) {
+            for (std::size_t l=0; l<reduce_lanes; ++l) part[l]=step(part[l], first[l]);
+        }
+        for (std::size_t l=0; l<n; ++l) part[l]=step(part[l], first[l]);
+
+        Acc acc=part[0];
+        for (std::size_t l=1; l<reduce_lanes; ++l) acc=combine(acc, part[l]);
+        return acc;
+    }
+} // namespace detail
+
+// Number of set elements.
+template <typename RandomIt>
+std::size_t reduce_count(RandomIt first, RandomIt last) {
+    typedef typename detail::reduce_value<RandomIt>::type X;
+    return detail::lane_reduce(first, last, std::size_t(0),
+        [](std::size_t n, const optional<X>& o) { return n+(o? 1: 0); },
+        [](std::size_t a, std::size_t b) { return a+b; });
+}
+
+// Sum of set elements; zero if none are set.
+template <typename RandomIt>
+typename detail::reduce_acc<typename detail::reduce_value<RandomIt>::type>::type
+reduce_sum(RandomIt first, RandomIt last) {
+    typedef typename detail::reduce_value<RandomIt>::type X;
+    typedef typename detail::reduce_acc<X>::type A;
+    return detail::lane_reduce(first, last, A(0),
+        [](A s, const optional<X>& o) { return s+A(detail::masked_value(o)); },
+        [](A a, A b) { return a+b; });
+}
+
+// Least set element, or nothing if none are set. NaN values are ignored.
+template <typename RandomIt>
+optional<typename detail::reduce_value<RandomIt>::type> reduce_min(RandomIt first, RandomIt last) {
+    typedef typename detail::reduce_value<RandomIt>::type X;
+    struct acc { X value; bool set; };
+
+    acc r=detail::lane_reduce(first, last, acc{detail::reduce_upper_bound<X>(), false},
+        [](acc a, const optional<X>& o) {
+            X x=detail::optional_raw_value(o);
+            bool take=bool(o) & (x<a.value);
+            return acc{detail::select_bits(take, x, a.value), bool(a.set | (bool(o) & (x==x)))};
+        },
+        [](acc a, acc b) { return acc{detail::select_bits(b.value<a.value, b.value, a.value), a.set || b.set}; });
+    return r.set? optional<X>(r.value): optional<X>();
+}
+
+// Greatest set element, or nothing if none are set. NaN values are ignored.
+template <typename RandomIt>
+optional<typename detail::reduce_value<RandomIt>::type> reduce_max(RandomIt first, RandomIt last) {
+    typedef typename detail::reduce_value<RandomIt>::type X;
+    struct acc { X value; bool set; };
+
+    acc r=detail::lane_reduce(first, last, acc{detail::reduce_lower_bound<X>(), false},
+        [](acc a, const optional<X>& o) {
+            X x=detail::optional_raw_value(o);
+            bool take=bool(o) & (x>a.value);
+            return acc{detail::select_bits(take, x, a.value), bool(a.set | (bool(o) & (x==x)))};
+        },
+        [](acc a, acc b) { return acc{detail::select_bits(b.value>a.value, b.value, a.value), a.set || b.set}; });
+    return r.set? optional<X>(r.value): optional<X>();
+}
+
+// Mean of set elements, or nothing if none are set.
+template <typename RandomIt>
+optional<double> reduce_mean(RandomIt first, RandomIt last) {
+    std::size_t n=reduce_count(first, last);
+    return n? optional<double>(double(reduce_sum(first, last))/n): optional<double>();
+}
+
+// Sum of products of corresponding elements that are both set.
+template <typename RandomIt1, typename RandomIt2>
+auto reduce_dot(RandomIt1 first1, RandomIt1 last1, RandomIt2 first2) ->
+    typename detail::reduce_acc<typename std::common_type<
+        typename detail::reduce_value<RandomIt1>::type,
+        typename detail::reduce_value<RandomIt2>::type>::type>::type
+{
+    typedef typename detail::reduce_value<RandomIt1>::type X;
+    typedef typename detail::reduce_value<RandomIt2>::type Y;
+    typedef typename detail::reduce_acc<typename std::common_type<X, Y>::type>::type A;
+
+    A part[detail::reduce_lanes]={};
+    std::size_t n=std::distance(first1, last1);
+    // Unset factors are zeroed, and the product masked too, so that an
+    // infinite or NaN factor does not leak through a zero.
+    auto product=[](const optional<X>& a, const optional<Y>& b) {
+        return detail::mask_value(A(detail::masked_value(a))*A(detail::masked_value(b)), bool(a) & bool(b));
+    };
+
+    for (; n>=detail::reduce_lanes; n-=detail::reduce_lanes, first1+=detail::reduce_lanes, first2+=detail::reduce_lanes) {
+        for (std::size_t l=0; l<detail::reduce_lanes; ++l) part[l]+=product(first1[l], first2[l]);
+    }
+    for (std::size_t l=0; l<n; ++l) part[l]+=product(first1[l], first2[l]);
+
+    A acc=part[0];
+    for (std::size_t l=1; l<detail::reduce_lanes; ++l) acc+=part[l];
+    return acc;
+}
+
+} // namespace hf
+
+#endif // ndef HF_REDUCE_H_
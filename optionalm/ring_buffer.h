@@ -0,0 +1,229 @@
+#ifndef HF_RING_BUFFER_H_
+#define HF_RING_BUFFER_H_
+
+/* Bounded lock-free queues with in-place construction of elements.
+ *
+ * `spsc_ring<T>` may be used by one producer thread and one consumer
+ * thread at a time; `mpmc_ring<T>` by any number of each. Both hold
+ * their elements in `uninitialized<T>` slots allocated once, so that
+ * `T` need not be default constructible: `try_emplace(args...)`
+ * constructs an element in its slot, and `try_pop()` moves it out
+ * into an `optional<T>`, unset if the queue was empty. `try_push` and
+ * `try_emplace` return false rather than wait if the queue is full.
+ *
+ * Capacities are rounded up to a power of two. The producer and
+ * consumer indices are kept on separate cache lines. In `spsc_ring`,
+ * each side also keeps a copy of the other's index, and reads the
+ * shared one only when its copy shows the queue full or empty.
+ *
+ * `mpmc_ring` follows D. Vyukov's bounded MPMC queue: each slot has a
+ * sequence number telling producers and consumers whose turn it is.
+ * A slot claimed by a producer must be filled, so an element that may
+ * throw on construction from the arguments is constructed first and
+ * then moved in; `T` must be nothrow move constructible.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/bits.h>
+#include <optionalm/optional.h>
+#include <optionalm/uninitialized.h>
+
+namespace hf {
+
+namespace detail {
+    inline std::size_t ring_capacity(std::size_t n, std::size_t min) {
+        std::size_t c=min;
+        while (c<n) c*=2;
+        return c;
+    }
+} // namespace detail
+
+template <typename T>
+class spsc_ring {
+    const std::size_t mask_;
+    std::unique_ptr<uninitialized<T>[]> slots_;
+
+    char pad0_[detail::cache_line_size];
+
+    // Consumer side.
+    std::atomic<std::size_t> head_;
+    std::size_t cached_tail_;
+
+    char pad1_[detail::cache_line_size];
+
+    // Producer side.
+    std::atomic<std::size_t> tail_;
+    std::size_t cached_head_;
+
+    char pad2_[detail::cache_line_size];
+
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+
+    explicit spsc_ring(size_type capacity):
+        mask_(detail::ring_capacity(capacity, 1)-1),
+        slots_(new uninitialized<T>[mask_+1]),
+        head_(0), cached_tail_(0), tail_(0), cached_head_(0)
+    {}
+
+    spsc_ring(const spsc_ring&)=delete;
+    spsc_ring& operator=(const spsc_ring&)=delete;
+
+    ~spsc_ring() {
+        for (size_type i=head_.load(); i!=tail_.load(); ++i) slots_[i&mask_].destruct();
+    }
+
+    size_type capacity() const { return mask_+1; }
+
+    // Exact only when called from the producer or consumer thread
+    // while the other is idle.
+    size_type size() const { return tail_.load(std::memory_order_acquire)-head_.load(std::memory_order_acquire); }
+    bool empty() const { return size()==0; }
+
+    // Producer.
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_type t=tail_.load(std::memory_order_relaxed);
+        if (t-cached_head_==capacity()) {
+            cached_head_=head_.load(std::memory_order_acquire);
+            if (t-cached_head_==capacity()) return false;
+        }
+
+        slots_[t&mask_].construct(std::forward<Args>(args)...);
+        tail_.store(t+1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& x) { return try_emplace(x); }
+    bool try_push(T&& x) { return try_emplace(std::move(x)); }
+
+    // Consumer.
+    optional<T> try_pop() {
+        size_type h=head_.load(std::memory_order_relaxed);
+        if (h==cached_tail_) {
+            cached_tail_=tail_.load(std::memory_order_acquire);
+            if (h==cached_tail_) return nothing;
+        }
+
+        uninitialized<T>& slot=slots_[h&mask_];
+        optional<T> x(std::move(slot.ref()));
+        slot.destruct();
+        head_.store(h+1, std::memory_order_release);
+        return x;
+    }
+};
+
+template <typename T>
+class mpmc_ring {
+    static_assert(std::is_nothrow_move_constructible<T>::value, "mpmc_ring requires a nothrow move constructible type");
+
+    // Slot i is free for the producer at position p when its sequence
+    // number is p, and full for the consumer at p when it is p+1.
+    struct cell {
+        std::atomic<std::size_t> seq;
+        uninitialized<T> value;
+    };
+
+    const std::size_t mask_;
+    std::unique_ptr<cell[]> cells_;
+
+    char pad0_[detail::cache_line_size];
+    std::atomic<std::size_t> enqueue_pos_;
+    char pad1_[detail::cache_line_size];
+    std::atomic<std::size_t> dequeue_pos_;
+    char pad2_[detail::cache_line_size];
+
+    // Claim a free slot, or return null if the queue is full.
+    cell* claim() {
+        std::size_t pos=enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell* c=&cells_[pos&mask_];
+            std::intptr_t dif=std::intptr_t(c->seq.load(std::memory_order_acquire))-std::intptr_t(pos);
+            if (dif==0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) return c;
+            }
+            else if (dif<0) return nullptr;
+            else pos=enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    template <typename... Args>
+    bool emplace_impl(std::true_type, Args&&... args) {
+        cell* c=claim();
+        if (!c) return false;
+
+        c->value.construct(std::forward<Args>(args)...);
+        c->seq.store(c->seq.load(std::memory_order_relaxed)+1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename... Args>
+    bool emplace_impl(std::false_type, Args&&... args) {
+        T x(std::forward<Args>(args)...);
+        return emplace_impl(std::true_type{}, std::move(x));
+    }
+
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+
+    explicit mpmc_ring(size_type capacity):
+        mask_(detail::ring_capacity(capacity, 2)-1),
+        cells_(new cell[mask_+1]),
+        enqueue_pos_(0), dequeue_pos_(0)
+    {
+        for (size_type i=0; i<=mask_; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    mpmc_ring(const mpmc_ring&)=delete;
+    mpmc_ring& operator=(const mpmc_ring&)=delete;
+
+    ~mpmc_ring() {
+        for (size_type i=dequeue_pos_.load(); i!=enqueue_pos_.load(); ++i) cells_[i&mask_].value.destruct();
+    }
+
+    size_type capacity() const { return mask_+1; }
+
+    // Approximate while producers or consumers are active.
+    size_type size() const { return enqueue_pos_.load(std::memory_order_acquire)-dequeue_pos_.load(std::memory_order_acquire); }
+    bool empty() const { return size()==0; }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        return emplace_impl(std::integral_constant<bool, std::is_nothrow_constructible<T, Args&&...>::value>{},
+            std::forward<Args>(args)...);
+    }
+
+    bool try_push(const T& x) { return try_emplace(x); }
+    bool try_push(T&& x) { return try_emplace(std::move(x)); }
+
+    optional<T> try_pop() {
+        std::size_t pos=dequeue_pos_.load(std::memory_order_relaxed);
+        cell* c;
+        for (;;) {
+            c=&cells_[pos&mask_];
+            std::intptr_t dif=std::intptr_t(c->seq.load(std::memory_order_acquire))-std::intptr_t(pos+1);
+            if (dif==0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break;
+            }
+            else if (dif<0) return nothing;
+            else pos=dequeue_pos_.load(std::memory_order_relaxed);
+        }
+
+        optional<T> x(std::move(c->value.ref()));
+        c->value.destruct();
+        c->seq.store(pos+mask_+1, std::memory_order_release);
+        return x;
+    }
+};
+
+} // namespace hf
+
+#endif // ndef HF_RING_BUFFER_H_
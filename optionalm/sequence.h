@@ -0,0 +1,251 @@
+#ifndef HF_SEQUENCE_H_
+#define HF_SEQUENCE_H_
+
+/* All-or-nothing collection of optional and either values.
+ *
+ * `sequence(first, last)` turns a sequence of `optional<X>` into an
+ * `optional<std::vector<X>>`, set only if every element is set. Over a
+ * sequence of `either<X, E>`, where field 0 holds a value and field 1
+ * an error, it gives an `either<std::vector<X>, E>` holding either all
+ * the values or the first error.
+ *
+ * `traverse(first, last, f)` is `sequence` applied to the results of
+ * `f` on each element, but stops calling `f` after the first failure.
+ *
+ * Over forward iterators, `sequence` first checks all elements for
+ * failure, so that the output vector is allocated only on success;
+ * both reserve the output once when the length is known in advance.
+ * Payloads are moved from rvalue elements, e.g. from the elements of
+ * an rvalue range passed as `sequence(std::move(r))`, or through
+ * `std::move_iterator`.
+ *
+ * `traverse(first, last, f, options)` over random access iterators
+ * calls `f` concurrently on `options.workers` threads, taking blocks of
+ * `options.grain` consecutive elements in order; `f` may then also be
+ * called on elements past the first failure. The result is the same
+ * as that of the sequential version. An exception thrown by `f` stops
+ * processing, and is rethrown once all threads have finished.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <optionalm/optional.h>
+#include <optionalm/either.h>
+
+namespace hf {
+
+struct traverse_options {
+    unsigned workers=1;
+    std::size_t grain=1024;
+};
+
+namespace detail {
+    // How to test, unwrap and report failure for each kind of element.
+    template <typename R>
+    struct sequence_traits;
+
+    template <typename X>
+    struct sequence_traits<optional<X>> {
+        static_assert(!std::is_reference<X>::value && !std::is_void<X>::value,
+            "sequence requires optional values of object type");
+
+        typedef X value_type;
+        typedef optional<std::vector<X>> result_type;
+
+        static bool ok(const optional<X>& r) { return bool(r); }
+
+        static const X& value(const optional<X>& r) { return *r; }
+        static X& value(optional<X>& r) { return *r; }
+        static X&& value(optional<X>&& r) { return std::move(*r); }
+
+        static result_type success(std::vector<X>&& v) { return result_type(std::move(v)); }
+
+        template <typename O>
+        static result_type failure(O&&) { return result_type(); }
+    };
+
+    template <typename X, typename E>
+    struct sequence_traits<either<X, E>> {
+        static_assert(!std::is_reference<X>::value, "sequence requires either values of object type");
+
+        typedef X value_type;
+        typedef either<std::vector<X>, E> result_type;
+
+        static bool ok(const either<X, E>& r) { return r.index()==0; }
+
+        static const X& value(const either<X, E>& r) { return r.template unsafe_get<0>(); }
+        static X& value(either<X, E>& r) { return r.template unsafe_get<0>(); }
+        static X&& value(either<X, E>&& r) { return std::move(r.template unsafe_get<0>()); }
+
+        static result_type success(std::vector<X>&& v) { return result_type(in_place_index_t<0>{}, std::move(v)); }
+
+        static result_type failure(const either<X, E>& r) {
+            if (r.index()!=1) throw bad_either_access("sequence of valueless either");
+            return result_type(in_place_index_t<1>{}, r.template unsafe_get<1>());
+        }
+
+        static result_type failure(either<X, E>&& r) {
+            if (r.index()!=1) throw bad_either_access("sequence of valueless either");
+            return result_type(in_place_index_t<1>{}, std::forward<E>(r.template unsafe_get<1>()));
+        }
+    };
+
+    template <typename It>
+    using sequence_traits_t=sequence_traits<typename std::iterator_traits<It>::value_type>;
+
+    template <typename It>
+    using iterator_category_t=typename std::iterator_traits<It>::iterator_category;
+
+    template <typename It>
+    std::size_t reserve_size(It first, It last, std::forward_iterator_tag) { return std::distance(first, last); }
+
+    template <typename It>
+    std::size_t reserve_size(It, It, std::input_iterator_tag) { return 0; }
+
+    // Single pass: give up on the first failure.
+    template <typename It>
+    typename sequence_traits_t<It>::result_type sequence(It first, It last, std::input_iterator_tag) {
+        typedef sequence_traits_t<It> traits;
+
+        std::vector<typename traits::value_type> out;
+        for (; first!=last; ++first) {
+            auto&& r=*first;
+            if (!traits::ok(r)) return traits::failure(std::forward<decltype(r)>(r));
+            out.push_back(traits::value(std::forward<decltype(r)>(r)));
+        }
+        return traits::success(std::move(out));
+    }
+
+    // Check every element before allocating anything.
+    template <typename It>
+    typename sequence_traits_t<It>::result_type sequence(It first, It last, std::forward_iterator_tag) {
+        typedef sequence_traits_t<It> traits;
+        typedef typename std::iterator_traits<It>::value_type R;
+
+        It bad=std::find_if(first, last, [](const R& r) { return !traits::ok(r); });
+        if (bad!=last) return traits::failure(*bad);
+
+        std::vector<typename traits::value_type> out;
+        out.reserve(std::distance(first, last));
+        for (; first!=last; ++first) out.push_back(traits::value(*first));
+        return traits::success(std::move(out));
+    }
+
+    template <typename It, typename F>
+    using traverse_result_t=typename std::decay<decltype(std::declval<F&>()(*std::declval<It&>()))>::type;
+
+    template <typename Range>
+    using range_sequence_iterator_t=typename std::conditional<std::is_lvalue_reference<Range>::value,
+        decltype(std::begin(std::declval<Range&>())),
+        std::move_iterator<decltype(std::begin(std::declval<Range&>()))>>::type;
+} // namespace detail
+
+template <typename InputIt>
+typename detail::sequence_traits_t<InputIt>::result_type sequence(InputIt first, InputIt last) {
+    return detail::sequence(first, last, detail::iterator_category_t<InputIt>{});
+}
+
+// Elements of an rvalue range are moved.
+template <typename Range>
+auto sequence(Range&& r) -> decltype(sequence(std::declval<detail::range_sequence_iterator_t<Range>>(), std::declval<detail::range_sequence_iterator_t<Range>>())) {
+    typedef detail::range_sequence_iterator_t<Range> It;
+    return sequence(It(std::begin(r)), It(std::end(r)));
+}
+
+template <typename InputIt, typename F>
+typename detail::sequence_traits<detail::traverse_result_t<InputIt, F>>::result_type
+traverse(InputIt first, InputIt last, F f) {
+    typedef detail::sequence_traits<detail::traverse_result_t<InputIt, F>> traits;
+
+    std::vector<typename traits::value_type> out;
+    out.reserve(detail::reserve_size(first, last, detail::iterator_category_t<InputIt>{}));
+    for (; first!=last; ++first) {
+        auto r=f(*first);
+        if (!traits::ok(r)) return traits::failure(std::move(r));
+        out.push_back(traits::value(std::move(r)));
+    }
+    return traits::success(std::move(out));
+}
+
+template <typename Range, typename F>
+auto traverse(Range&& r, F f) -> decltype(traverse(std::declval<detail::range_sequence_iterator_t<Range>>(), std::declval<detail::range_sequence_iterator_t<Range>>(), f)) {
+    typedef detail::range_sequence_iterator_t<Range> It;
+    return traverse(It(std::begin(r)), It(std::end(r)), std::move(f));
+}
+
+template <typename RandomIt, typename F>
+typename detail::sequence_traits<detail::traverse_result_t<RandomIt, F>>::result_type
+traverse(RandomIt first, RandomIt last, F f, const traverse_options& options) {
+    typedef detail::traverse_result_t<RandomIt, F> R;
+    typedef detail::sequence_traits<R> traits;
+    static_assert(std::is_base_of<std::random_access_iterator_tag, detail::iterator_category_t<RandomIt>>::value,
+        "parallel traverse requires random access iterators");
+
+    std::size_t n=std::distance(first, last);
+    std::size_t grain=options.grain? options.grain: 1;
+    if (options.workers<=1 || n<=grain) return traverse(first, last, std::move(f));
+
+    // Index of the first failure found so far, or n; blocks are taken
+    // in order, so every element before the first failure is visited.
+    std::vector<optional<R>> results(n);
+    std::atomic<std::size_t> next_block(0), failed(n);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto work=[&]() {
+        try {
+            for (;;) {
+                std::size_t b=next_block.fetch_add(grain);
+                if (b>=n || b>=failed.load()) return;
+
+                for (std::size_t i=b; i<std::min(n, b+grain) && i<failed.load(std::memory_order_relaxed); ++i) {
+                    results[i].emplace(f(first[i]));
+                    if (!traits::ok(*results[i])) {
+                        std::size_t seen=failed.load();
+                        while (i<seen && !failed.compare_exchange_weak(seen, i)) {}
+                        return;
+                    }
+                }
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error=std::current_exception();
+            failed=0;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    unsigned n_threads=std::min<std::size_t>(options.workers, (n+grain-1)/grain);
+    try {
+        for (unsigned i=1; i<n_threads; ++i) threads.emplace_back(work);
+    }
+    catch (...) {
+        failed=0;
+        for (auto& t: threads) t.join();
+        throw;
+    }
+    work();
+    for (auto& t: threads) t.join();
+
+    if (error) std::rethrow_exception(error);
+    if (failed<n) return traits::failure(std::move(*results[failed]));
+
+    std::vector<typename traits::value_type> out;
+    out.reserve(n);
+    for (auto& r: results) out.push_back(traits::value(std::move(*r)));
+    return traits::success(std::move(out));
+}
+
+} // namespace hf
+
+#endif // ndef HF_SEQUENCE_H_
@@ -0,0 +1,314 @@
+#ifndef HF_SHARED_OPTIONAL_H_
+#define HF_SHARED_OPTIONAL_H_
+
+/* Optional values read concurrently by many threads and updated rarely.
+ *
+ * `seqlock_optional<T>`, for trivially copyable `T`, holds the value
+ * under a sequence lock: `load()` copies the value and retries if a
+ * writer was active meanwhile, and so writes no shared memory. Writers
+ * are serialized by a mutex, and bump the sequence number before and
+ * after updating the value.
+ *
+ * `rcu_optional<T>` holds a pointer to an immutable `optional<T>` that
+ * writers replace with a new copy. `read(f)` calls `f` with a const
+ * reference to the current value; a writer frees the previous copy only
+ * once every reader that could be using it has finished (a grace
+ * period, as in sleepable RCU). Each thread that reads announces itself
+ * on a reader record of its own, on its own cache line, which no other
+ * thread writes; writers walk the list of records to wait for readers.
+ * Records are shared by all `rcu_optional` values, and are kept for
+ * reuse by later threads when a thread exits.
+ *
+ * In both, the writer functions `store`, `reset` and `update` may be
+ * called concurrently with each other and with readers. `rcu_optional`
+ * writers wait for the readers of every `rcu_optional`, and so must not
+ * be called from within `read`.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/bits.h>
+#include <optionalm/optional.h>
+#include <optionalm/uninitialized.h>
+
+namespace hf {
+
+namespace detail {
+    // Representation of an optional trivially copyable value, copied
+    // in and out of a seqlock_optional as a whole.
+    template <typename T>
+    struct seqlock_payload {
+        uninitialized<T> value;
+        bool set;
+    };
+} // namespace detail
+
+template <typename T>
+class seqlock_optional {
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock_optional requires a trivially copyable type");
+
+    typedef detail::seqlock_payload<T> payload;
+    static constexpr std::size_t n_words=(sizeof(payload)+7)/8;
+
+    // The value is held in atomic words so that a read overlapping a
+    // write is not a data race; the sequence number tells the reader
+    // whether to discard what it read.
+    std::atomic<std::uint64_t> seq_;
+    std::atomic<std::uint64_t> words_[n_words];
+    std::mutex write_mutex_;
+
+    void read_words(std::uint64_t* buf) const {
+        for (;;) {
+            std::uint64_t s=seq_.load(std::memory_order_acquire);
+            if (s&1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (std::size_t k=0; k<n_words; ++k) buf[k]=words_[k].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed)==s) return;
+        }
+    }
+
+    // Precondition: write_mutex_ is held.
+    void publish(const optional<T>& x) {
+        payload p=payload();
+        p.set=bool(x);
+        if (x) p.value.construct(*x);
+
+        std::uint64_t buf[n_words]={};
+        std::memcpy(buf, &p, sizeof(p));
+
+        std::uint64_t s=seq_.load(std::memory_order_relaxed);
+        seq_.store(s+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t k=0; k<n_words; ++k) words_[k].store(buf[k], std::memory_order_relaxed);
+        seq_.store(s+2, std::memory_order_release);
+    }
+
+public:
+    typedef T value_type;
+
+    seqlock_optional(): seqlock_optional(optional<T>()) {}
+    seqlock_optional(nothing_t): seqlock_optional(optional<T>()) {}
+
+    seqlock_optional(const optional<T>& x): seq_(0) {
+        for (auto& w: words_) w.store(0, std::memory_order_relaxed);
+        publish(x);
+    }
+
+    seqlock_optional(const seqlock_optional&)=delete;
+    seqlock_optional& operator=(const seqlock_optional&)=delete;
+
+    // A consistent copy of the value.
+    optional<T> load() const {
+        std::uint64_t buf[n_words];
+        read_words(buf);
+
+        payload p;
+        std::memcpy(&p, buf, sizeof(p));
+        return p.set? optional<T>(p.value.cref()): optional<T>();
+    }
+
+    void store(const optional<T>& x) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        publish(x);
+    }
+
+    void reset() { store(optional<T>()); }
+
+    // Replace the value with that left in its copy by `f(optional<T>&)`;
+    // no other write intervenes.
+    template <typename F>
+    void update(F&& f) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        optional<T> x=load();
+        std::forward<F>(f)(x);
+        publish(x);
+    }
+
+    // Incremented twice by each write.
+    std::uint64_t version() const { return seq_.load(std::memory_order_acquire); }
+};
+
+template <typename T>
+constexpr std::size_t seqlock_optional<T>::n_words;
+
+namespace detail {
+    // Counts of the readers of one thread active in each of the two
+    // phases. Only the owning thread modifies the counts.
+    struct alignas(cache_line_size) rcu_reader {
+        std::atomic<std::size_t> active[2];
+        std::atomic<bool> in_use;
+        rcu_reader* next;
+    };
+    static_assert(sizeof(rcu_reader)==cache_line_size, "each reader record must occupy one cache line");
+
+    // The list of reader records and the phase shared by all
+    // rcu_optional values. Records are only ever added to the list,
+    // so that writers may walk it without locking; the list head is
+    // accessed sequentially consistently, so that a writer either sees
+    // the record of a new reader or that reader sees the new value.
+    class rcu_domain {
+        std::atomic<rcu_reader*> head_;
+        std::atomic<std::size_t> phase_;
+        std::mutex register_mutex_;
+        std::mutex grace_mutex_;
+
+        rcu_domain(): head_(nullptr), phase_(0) {}
+
+        // Before C++17, new does not honour the alignment of `rcu_reader`:
+        // the record is placed at a cache line boundary within a larger,
+        // never freed, allocation.
+        static rcu_reader* make_reader() {
+            char* storage=new char[sizeof(rcu_reader)+cache_line_size];
+            std::uintptr_t addr=reinterpret_cast<std::uintptr_t>(storage);
+            std::uintptr_t aligned=(addr+cache_line_size-1)/cache_line_size*cache_line_size;
+            rcu_reader* r=::new(static_cast<void*>(storage+(aligned-addr))) rcu_reader();
+            r->active[0].store(0, std::memory_order_relaxed);
+            r->active[1].store(0, std::memory_order_relaxed);
+            r->in_use.store(true, std::memory_order_relaxed);
+            return r;
+        }
+
+        // Claim a record left by an exited thread, or add a new one.
+        rcu_reader* acquire() {
+            std::lock_guard<std::mutex> lock(register_mutex_);
+            for (rcu_reader* r=head_.load(); r; r=r->next) {
+                if (!r->in_use.load(std::memory_order_relaxed)) {
+                    r->in_use.store(true, std::memory_order_relaxed);
+                    return r;
+                }
+            }
+
+            rcu_reader* r=make_reader();
+            r->next=head_.load(std::memory_order_relaxed);
+            head_.store(r);
+            return r;
+        }
+
+        void release(rcu_reader* r) {
+            std::lock_guard<std::mutex> lock(register_mutex_);
+            r->in_use.store(false, std::memory_order_relaxed);
+        }
+
+        // Registers the record of a thread on its first read, and
+        // returns it for reuse at thread exit.
+        struct registration {
+            rcu_reader* reader;
+            registration(): reader(instance().acquire()) {}
+            ~registration() { instance().release(reader); }
+        };
+
+    public:
+        // Never destroyed, so that it outlives the records of threads
+        // that exit after static destruction has begun.
+        static rcu_domain& instance() {
+            static rcu_domain* d=new rcu_domain;
+            return *d;
+        }
+
+        static rcu_reader& local_reader() {
+            static thread_local registration r;
+            return *r.reader;
+        }
+
+        std::atomic<std::size_t>& reader_count(rcu_reader& r) {
+            return r.active[phase_.load()&1];
+        }
+
+        // Wait until no reader could still hold a value loaded before the
+        // call. A reader that read the phase before a flip but counted
+        // after it is seen by the second flip, as in sleepable RCU.
+        void synchronize() {
+            std::lock_guard<std::mutex> lock(grace_mutex_);
+            for (int flip=0; flip<2; ++flip) {
+                std::size_t p=phase_.fetch_add(1)&1;
+                for (rcu_reader* r=head_.load(); r; r=r->next) {
+                    while (r->active[p].load()) std::this_thread::yield();
+                }
+            }
+        }
+    };
+} // namespace detail
+
+template <typename T>
+class rcu_optional {
+    std::atomic<const optional<T>*> current_;
+    std::mutex write_mutex_;
+
+    // Decrements the reader count on leaving `read`, also if `f` throws.
+    struct read_guard {
+        std::atomic<std::size_t>& count;
+        ~read_guard() { count.fetch_sub(1, std::memory_order_release); }
+    };
+
+    // Precondition: write_mutex_ is held.
+    void replace(const optional<T>* x) {
+        const optional<T>* old=current_.exchange(x);
+        detail::rcu_domain::instance().synchronize();
+        delete old;
+    }
+
+public:
+    typedef T value_type;
+
+    rcu_optional(): rcu_optional(optional<T>()) {}
+    rcu_optional(nothing_t): rcu_optional(optional<T>()) {}
+
+    rcu_optional(optional<T> x): current_(new optional<T>(std::move(x))) {}
+
+    rcu_optional(const rcu_optional&)=delete;
+    rcu_optional& operator=(const rcu_optional&)=delete;
+
+    // Precondition: no reader or writer is active.
+    ~rcu_optional() { delete current_.load(std::memory_order_relaxed); }
+
+    // Return `f(const optional<T>&)` applied to the current value; the
+    // reference is valid until `f` returns.
+    template <typename F>
+    auto read(F&& f) const -> decltype(std::forward<F>(f)(std::declval<const optional<T>&>())) {
+        detail::rcu_reader& reader=detail::rcu_domain::local_reader();
+        std::atomic<std::size_t>& count=detail::rcu_domain::instance().reader_count(reader);
+
+        count.fetch_add(1);
+        read_guard guard{count};
+        return std::forward<F>(f)(*current_.load());
+    }
+
+    optional<T> load() const {
+        return read([](const optional<T>& x) { return x; });
+    }
+
+    void store(optional<T> x) {
+        std::unique_ptr<const optional<T>> p(new optional<T>(std::move(x)));
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        replace(p.release());
+    }
+
+    void reset() { store(optional<T>()); }
+
+    // Replace the value with that left in its copy by `f(optional<T>&)`;
+    // no other write intervenes.
+    template <typename F>
+    void update(F&& f) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        std::unique_ptr<optional<T>> p(new optional<T>(*current_.load()));
+        std::forward<F>(f)(*p);
+        replace(p.release());
+    }
+};
+
+} // namespace hf
+
+#endif // ndef HF_SHARED_OPTIONAL_H_
@@ -0,0 +1,189 @@
+#ifndef HF_STD_INTEROP_H_
+#define HF_STD_INTEROP_H_
+
+/* Conversions between `optional` and `either` and their counterparts
+ * in the C++17 and C++23 standard libraries.
+ *
+ * `from_std(x)` converts a `std::optional<X>` to an `optional<X>`, a
+ * `std::variant<A, B>` to an `either<A, B>`, and a `std::expected<T, E>`
+ * to an `either<T, E>` (value in field 0, error in field 1). In the other
+ * direction, `to_std_optional(o)`, `to_variant(e)` and `to_expected(e)`.
+ * Each payload is moved if the argument is an rvalue, and copied
+ * otherwise; the payload is constructed only once.
+ *
+ * `borrow(x)` instead refers to the payload of a standard library value
+ * without copying it, as an `optional<X&>` or `either<A&, B&>`, or with
+ * `const` references for a const argument. The borrowed references are
+ * valid as long as the payload of `x` is.
+ *
+ * The `std::optional` and `std::variant` conversions require C++17;
+ * those for `std::expected` are defined only if the library provides it.
+ * A valueless variant, either, or expected cannot be converted, and
+ * throws `bad_either_access`.
+ */
+
+#include <type_traits>
+#include <utility>
+
+#include <optionalm/optional.h>
+#include <optionalm/either.h>
+
+#if __cplusplus>=201703L
+#include <optional>
+#include <variant>
+
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
+namespace hf {
+
+// std::optional
+
+template <typename X>
+optional<X> from_std(const std::optional<X>& o) {
+    return o? optional<X>(*o): optional<X>();
+}
+
+template <typename X>
+optional<X> from_std(std::optional<X>&& o) {
+    return o? optional<X>(std::move(*o)): optional<X>();
+}
+
+template <typename X>
+optional<X&> borrow(std::optional<X>& o) {
+    return o? optional<X&>(*o): optional<X&>();
+}
+
+template <typename X>
+optional<const X&> borrow(const std::optional<X>& o) {
+    return o? optional<const X&>(*o): optional<const X&>();
+}
+
+template <typename X>
+std::optional<X> to_std_optional(const optional<X>& o) {
+    return o? std::optional<X>(std::in_place, *o): std::optional<X>();
+}
+
+template <typename X>
+std::optional<X> to_std_optional(optional<X>&& o) {
+    return o? std::optional<X>(std::in_place, std::move(*o)): std::optional<X>();
+}
+
+// std::variant
+
+namespace detail {
+    template <typename R, typename V>
+    R either_from_variant(V&& v) {
+        switch (v.index()) {
+        case 0:
+            return R(in_place_index_t<0>{}, std::get<0>(std::forward<V>(v)));
+        case 1:
+            return R(in_place_index_t<1>{}, std::get<1>(std::forward<V>(v)));
+        default:
+            throw bad_either_access("conversion of valueless variant");
+        }
+    }
+
+    template <typename R, typename E>
+    R variant_from_either(E&& e) {
+        switch (e.index()) {
+        case 0:
+            return R(std::in_place_index<0>, either_forward<0>(std::forward<E>(e)));
+        case 1:
+            return R(std::in_place_index<1>, either_forward<1>(std::forward<E>(e)));
+        default:
+            throw bad_either_access("conversion of valueless either");
+        }
+    }
+} // namespace detail
+
+template <typename A, typename B>
+either<A, B> from_std(const std::variant<A, B>& v) {
+    return detail::either_from_variant<either<A, B>>(v);
+}
+
+template <typename A, typename B>
+either<A, B> from_std(std::variant<A, B>&& v) {
+    return detail::either_from_variant<either<A, B>>(std::move(v));
+}
+
+template <typename A, typename B>
+either<A&, B&> borrow(std::variant<A, B>& v) {
+    return detail::either_from_variant<either<A&, B&>>(v);
+}
+
+template <typename A, typename B>
+either<const A&, const B&> borrow(const std::variant<A, B>& v) {
+    return detail::either_from_variant<either<const A&, const B&>>(v);
+}
+
+template <typename A, typename B>
+std::variant<A, B> to_variant(const either<A, B>& e) {
+    return detail::variant_from_either<std::variant<A, B>>(e);
+}
+
+template <typename A, typename B>
+std::variant<A, B> to_variant(either<A, B>&& e) {
+    return detail::variant_from_either<std::variant<A, B>>(std::move(e));
+}
+
+// std::expected
+
+#if defined(__cpp_lib_expected)
+namespace detail {
+    template <typename R, typename X>
+    R either_from_expected(X&& x) {
+        if (x) return R(in_place_index_t<0>{}, *std::forward<X>(x));
+        return R(in_place_index_t<1>{}, std::forward<X>(x).error());
+    }
+
+    template <typename R, typename E>
+    R expected_from_either(E&& e) {
+        switch (e.index()) {
+        case 0:
+            return R(std::in_place, either_forward<0>(std::forward<E>(e)));
+        case 1:
+            return R(std::unexpect, either_forward<1>(std::forward<E>(e)));
+        default:
+            throw bad_either_access("conversion of valueless either");
+        }
+    }
+} // namespace detail
+
+template <typename T, typename E>
+either<T, E> from_std(const std::expected<T, E>& x) {
+    return detail::either_from_expected<either<T, E>>(x);
+}
+
+template <typename T, typename E>
+either<T, E> from_std(std::expected<T, E>&& x) {
+    return detail::either_from_expected<either<T, E>>(std::move(x));
+}
+
+template <typename T, typename E>
+either<T&, E&> borrow(std::expected<T, E>& x) {
+    return detail::either_from_expected<either<T&, E&>>(x);
+}
+
+template <typename T, typename E>
+either<const T&, const E&> borrow(const std::expected<T, E>& x) {
+    return detail::either_from_expected<either<const T&, const E&>>(x);
+}
+
+template <typename T, typename E>
+std::expected<T, E> to_expected(const either<T, E>& e) {
+    return detail::expected_from_either<std::expected<T, E>>(e);
+}
+
+template <typename T, typename E>
+std::expected<T, E> to_expected(either<T, E>&& e) {
+    return detail::expected_from_either<std::expected<T, E>>(std::move(e));
+}
+#endif // defined(__cpp_lib_expected)
+
+} // namespace hf
+
+#endif // __cplusplus>=201703L
+
+#endif // ndef HF_STD_INTEROP_H_
@@ -11,10 +11,82 @@
  *
  * The specialization `uninitialized<void>` is included to
  * ease generic code; destruction and construction are NOPs.
+ *
+ * The tag types `in_place_t` and `in_place_index_t<I>` are used
+ * by `optional` and `either` to select constructors that build
+ * their value directly in `uninitialized` storage.
+ *
+ * The trait `is_trivially_relocatable<X>` is true if moving an `X`
+ * to a new address and destroying the original is equivalent to
+ * copying its bytes. It may be specialized for user types; the
+ * `relocate` functions use it to move values with `memcpy`.
  */
 
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 namespace hf {
 
+namespace detail {
+    struct ctor_tag {};
+
+    // An `optional` or `either` constructed from a `result_slot` is
+    // left unset or valueless, and records its address in `target`,
+    // so that its value can be supplied later (see coroutine.h).
+    template <typename R>
+    struct result_slot: ctor_tag {
+        R* target=nullptr;
+    };
+
+    namespace swap_adl {
+        using std::swap;
+
+        template <typename X>
+        struct is_nothrow_swappable {
+            enum { value=noexcept(swap(std::declval<X&>(), std::declval<X&>())) };
+        };
+    }
+
+    using swap_adl::is_nothrow_swappable;
+
+    // How uses-allocator construction of `X` from `Args` passes an
+    // allocator: not at all (0), following `std::allocator_arg` (1),
+    // or as a trailing argument (2).
+    template <typename X, typename Alloc, typename... Args>
+    struct uses_allocator_kind: std::integral_constant<int,
+        !std::uses_allocator<X, Alloc>::value? 0:
+        std::is_constructible<X, std::allocator_arg_t, const Alloc&, Args...>::value? 1: 2> {};
+
+    template <typename X, typename Alloc, typename... Args>
+    void construct_using_allocator(void* p, std::integral_constant<int, 0>, const Alloc&, Args&&... args) {
+        new(p) X(std::forward<Args>(args)...);
+    }
+
+    template <typename X, typename Alloc, typename... Args>
+    void construct_using_allocator(void* p, std::integral_constant<int, 1>, const Alloc& alloc, Args&&... args) {
+        new(p) X(std::allocator_arg, alloc, std::forward<Args>(args)...);
+    }
+
+    template <typename X, typename Alloc, typename... Args>
+    void construct_using_allocator(void* p, std::integral_constant<int, 2>, const Alloc& alloc, Args&&... args) {
+        new(p) X(std::forward<Args>(args)..., alloc);
+    }
+}
+
+template <std::size_t I>
+struct in_place_index_t: detail::ctor_tag {};
+
+#if defined(__cpp_variable_templates)
+template <std::size_t I> constexpr in_place_index_t<I> in_place_index{};
+#endif
+
+struct in_place_t: detail::ctor_tag {};
+constexpr in_place_t in_place{};
+
 template <typename X>
 struct uninitialized {
 private:
@@ -44,19 +116,36 @@ public:
     template <typename... Y,typename =typename std::enable_if<std::is_constructible<X,Y...>::value>::type>
     void construct(Y&& ...args) { new(&data) X(std::forward<Y>(args)...); }
 
+    // Construct the value from the arguments with uses-allocator
+    // construction: `alloc` is passed to the constructor if `X` uses
+    // allocators of its type (see `std::uses_allocator`).
+    template <typename Alloc, typename... Y>
+    void construct_using_allocator(const Alloc& alloc, Y&& ...args) {
+        detail::construct_using_allocator<X>(&data, detail::uses_allocator_kind<X, Alloc, Y...>{}, alloc, std::forward<Y>(args)...);
+    }
+
     // Assign the value (precondition: value already constructed).
     void assign(const X& x) { ref()=x; }
     void assign(X&& x) { ref()=std::move(x); }
 
+    // Swap values with another (constructed) uninitialized value.
+    void swap(uninitialized& u) noexcept(detail::is_nothrow_swappable<X>::value) {
+        using std::swap;
+        swap(ref(), u.ref());
+    }
+
     // Call the destructor of the value.
     void destruct() { ptr()->~X(); }
 
     // Apply the one-parameter functor F to the value by reference.
     template <typename F>
-    typename std::result_of<F(reference)>::type apply(F &&f) { return f(ref()); }
+    typename std::result_of<F(reference)>::type apply(F &&f) & { return f(ref()); }
     // Apply the one-parameter functor F to the value by const reference.
     template <typename F>
-    typename std::result_of<F(const_reference)>::type apply(F &&f) const { return f(cref()); }
+    typename std::result_of<F(const_reference)>::type apply(F &&f) const & { return f(cref()); }
+    // Apply the one-parameter functor F to the value by rvalue reference.
+    template <typename F>
+    typename std::result_of<F(X&&)>::type apply(F &&f) && { return f(std::move(ref())); }
 };
 
 template <typename X>
@@ -83,9 +172,16 @@ public:
     // Set the reference data.
     void construct(X &x) { data=&x; }
 
+    // References do not use allocators.
+    template <typename Alloc>
+    void construct_using_allocator(const Alloc&, X &x) { data=&x; }
+
     // Reassign the reference; explicitly allow const breaking.
     void assign(const X& x) { data=const_cast<X*>(&x); }
 
+    // Swap references with another uninitialized reference.
+    void swap(uninitialized& u) noexcept { std::swap(data, u.data); }
+
     // Destruct is a NOP for reference data.
     void destruct() {}
 
@@ -118,6 +214,47 @@ struct uninitialized<void> {
     typename std::result_of<F()>::type apply(F &&f) const { return f(); }
 };
 
+template <typename X>
+struct is_trivially_relocatable:
+    std::integral_constant<bool, std::is_trivially_copyable<X>::value || std::is_reference<X>::value> {};
+
+template <typename X>
+struct is_trivially_relocatable<uninitialized<X>>: is_trivially_relocatable<X> {};
+
+// A unique_ptr with the default deleter is a lone pointer in every
+// standard library implementation.
+template <typename X>
+struct is_trivially_relocatable<std::unique_ptr<X>>: std::true_type {};
+
+// Move-construct values in the uninitialized storage at `dest` from
+// those in [first, last), and destroy the originals. The ranges must
+// not overlap. If a move constructor throws, values already
+// constructed at `dest` are destroyed and the source is left intact.
+template <typename X>
+X* relocate(X* first, X* last, X* dest) {
+    typedef typename std::remove_cv<X>::type value_type;
+
+    if (is_trivially_relocatable<value_type>::value) {
+        std::size_t n=last-first;
+        if (n) std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), n*sizeof(X));
+        return dest+n;
+    }
+
+    X* out=dest;
+    try {
+        for (X* p=first; p!=last; ++p, ++out) {
+            ::new(static_cast<void*>(out)) value_type(std::move(*p));
+        }
+    }
+    catch (...) {
+        for (X* p=dest; p!=out; ++p) p->~X();
+        throw;
+    }
+
+    for (X* p=first; p!=last; ++p) p->~X();
+    return out;
+}
+
 } // namespace hf
 
 #endif // ndef HF_UNINITIALIZED_H_
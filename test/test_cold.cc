@@ -0,0 +1,137 @@
+#include <array>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/cold.h>
+#include <optionalm/either.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+namespace {
+    struct big_error {
+        std::string message;
+        std::array<int, 32> context;
+
+        explicit big_error(std::string m=""): message(std::move(m)), context() {}
+        bool operator==(const big_error& x) const { return message==x.message; }
+    };
+
+    typedef detail::cold_pool<detail::cold_block_size(sizeof(big_error))> big_pool;
+}
+
+TEST(cold, value) {
+    cold<big_error> a(big_error("a"));
+    EXPECT_FALSE(a.empty());
+    EXPECT_EQ("a", a->message);
+    EXPECT_EQ("a", a.get().message);
+
+    cold<big_error> b(in_place, "b");
+    EXPECT_EQ("b", (*b).message);
+    EXPECT_FALSE(a==b);
+
+    cold<big_error> c(a);
+    EXPECT_EQ(a, c);
+    EXPECT_NE(&*a, &*c);
+
+    const big_error* p=&*c;
+    cold<big_error> d(std::move(c));
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(p, &*d);
+
+    c=b;
+    EXPECT_EQ("b", c->message);
+    c=std::move(d);
+    EXPECT_EQ(p, &*c);
+    EXPECT_TRUE(d.empty());
+
+    swap(a, c);
+    EXPECT_EQ(p, &*a);
+    EXPECT_EQ("a", c->message);
+
+    EXPECT_TRUE(cold<int>(1)<cold<int>(2));
+    EXPECT_TRUE(cold<int>(2)>=cold<int>(2));
+}
+
+TEST(cold, reuse) {
+    const big_error* p;
+    {
+        cold<big_error> a(big_error("a"));
+        p=&*a;
+    }
+    std::size_t cached=big_pool::local().size;
+    EXPECT_LE(1u, cached);
+
+    // The most recently freed block is taken first.
+    cold<big_error> b(big_error("b"));
+    EXPECT_EQ(p, &*b);
+    EXPECT_EQ(cached-1, big_pool::local().size);
+
+    // The free list is bounded.
+    {
+        std::vector<cold<big_error>> v;
+        for (std::size_t i=0; i<2*cold_cache_limit; ++i) v.emplace_back(in_place, "x");
+    }
+    EXPECT_EQ(cold_cache_limit, big_pool::local().size);
+}
+
+TEST(cold, either) {
+    typedef either<int, cold<big_error>> result;
+
+    EXPECT_EQ(sizeof(either<int, big_error*>), sizeof(result));
+    EXPECT_LT(sizeof(result), sizeof(either<int, big_error>));
+    EXPECT_TRUE(is_trivially_relocatable<result>::value);
+
+    auto f=[](int i) -> result {
+        if (i<0) return big_error("negative");
+        return i;
+    };
+
+    std::size_t cached=big_pool::local().size;
+    result r=f(3);
+    EXPECT_EQ(3, r.unsafe_get<0>());
+    EXPECT_EQ(cached, big_pool::local().size);
+
+    result e=f(-1);
+    ASSERT_EQ(1u, e.index());
+    EXPECT_EQ("negative", e.unsafe_get<1>()->message);
+
+    result e2=e;
+    EXPECT_EQ(e, e2);
+    EXPECT_NE(&*e.unsafe_get<1>(), &*e2.unsafe_get<1>());
+
+    r=std::move(e2);
+    EXPECT_EQ(e, r);
+}
+
+TEST(cold, relocate) {
+    uninitialized<cold<std::string>> src[3], dest[3];
+    src[0].construct(std::string("a"));
+    src[1].construct(std::string("b"));
+    src[2].construct(std::string("c"));
+    const std::string* p=&*src[1].ref();
+
+    relocate(&src[0].ref(), &src[0].ref()+3, &dest[0].ref());
+    EXPECT_EQ(p, &*dest[1].ref());
+    EXPECT_EQ("c", *dest[2].ref());
+
+    for (auto& d: dest) d.destruct();
+}
+
+TEST(cold, threads) {
+    // Blocks freed on another thread are cached there, and freed at its exit.
+    std::vector<cold<big_error>> v;
+    for (int i=0; i<10; ++i) v.emplace_back(in_place, "x");
+
+    std::size_t cached=0;
+    std::thread t([&]() {
+        v.clear();
+        cached=big_pool::local().size;
+    });
+    t.join();
+    EXPECT_EQ(10u, cached);
+}
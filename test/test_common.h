@@ -1,6 +1,8 @@
 #ifndef HF_OPTIONALM_TEST_COMMON_H
 #define HF_OPTIONALM_TEST_COMMON_H
 
+#include <cstddef>
+#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -104,6 +106,58 @@ struct no_move {
 template <typename V> int no_move<V>::copy_ctor_count;
 template <typename V> int no_move<V>::copy_assign_count;
 
+// Stateful allocator identified by `id`.
+template <typename T>
+struct tagged_allocator {
+    typedef T value_type;
+    int id;
+
+    explicit tagged_allocator(int id_=0): id(id_) {}
+
+    template <typename U>
+    tagged_allocator(const tagged_allocator<U>& a): id(a.id) {}
+
+    T* allocate(std::size_t n) { return std::allocator<T>().allocate(n); }
+    void deallocate(T* p, std::size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    template <typename U>
+    bool operator==(const tagged_allocator<U>& a) const { return id==a.id; }
+    template <typename U>
+    bool operator!=(const tagged_allocator<U>& a) const { return id!=a.id; }
+};
+
+// Value recording the id of the allocator it was constructed with, or
+// -1. Takes the allocator after `std::allocator_arg` or, if `trailing`
+// is true, as the last constructor argument.
+template <bool trailing=false>
+struct uses_tagged_allocator {
+    typedef tagged_allocator<char> allocator_type;
+
+    int value;
+    int alloc_id=-1;
+
+    uses_tagged_allocator(int v=0): value(v) {}
+    uses_tagged_allocator(const uses_tagged_allocator& x): value(x.value) {}
+    uses_tagged_allocator(uses_tagged_allocator&& x): value(x.value) {}
+
+    template <bool t=trailing, typename =typename std::enable_if<!t>::type>
+    uses_tagged_allocator(std::allocator_arg_t, const allocator_type& a, int v=0): value(v), alloc_id(a.id) {}
+
+    template <bool t=trailing, typename =typename std::enable_if<!t>::type>
+    uses_tagged_allocator(std::allocator_arg_t, const allocator_type& a, const uses_tagged_allocator& x): value(x.value), alloc_id(a.id) {}
+
+    template <bool t=trailing, typename =typename std::enable_if<t>::type>
+    uses_tagged_allocator(int v, const allocator_type& a): value(v), alloc_id(a.id) {}
+
+    template <bool t=trailing, typename =typename std::enable_if<t>::type>
+    uses_tagged_allocator(const uses_tagged_allocator& x, const allocator_type& a): value(x.value), alloc_id(a.id) {}
+
+    uses_tagged_allocator& operator=(const uses_tagged_allocator& x) {
+        value=x.value;
+        return *this;
+    }
+};
+
 }
 
 #endif // HF_OPTIONALM_TEST_COMMON_H
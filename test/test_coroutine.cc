@@ -0,0 +1,184 @@
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+
+#include <optionalm/coroutine.h>
+
+#include "test_common.h"
+
+#if defined(__cpp_impl_coroutine)
+
+using namespace hf;
+
+optional<int> parse_digit(char c) {
+    if (c<'0' || c>'9') return nothing;
+    return c-'0';
+}
+
+optional<int> sum_digits(const char* s, int& steps) {
+    int sum=0;
+    for (; *s; ++s) {
+        sum+=co_await parse_digit(*s);
+        ++steps;
+    }
+    co_return sum;
+}
+
+TEST(coroutine, optional) {
+    int steps=0;
+    auto a=sum_digits("1234", steps);
+    EXPECT_EQ(typeid(optional<int>), typeid(a));
+    ASSERT_TRUE((bool)a);
+    EXPECT_EQ(10, *a);
+    EXPECT_EQ(4, steps);
+
+    steps=0;
+    auto b=sum_digits("12x4", steps);
+    EXPECT_FALSE((bool)b);
+    EXPECT_EQ(2, steps);
+}
+
+optional<double> co_return_nothing(bool flag) {
+    if (flag) co_return 1.5;
+    co_return nothing;
+}
+
+TEST(coroutine, optional_return) {
+    EXPECT_EQ(1.5, *co_return_nothing(true));
+    EXPECT_FALSE((bool)co_return_nothing(false));
+}
+
+TEST(coroutine, optional_destroys_locals) {
+    auto token=std::make_shared<int>(3);
+
+    auto f=[](std::shared_ptr<int> p, optional<int> o) -> optional<int> {
+        std::shared_ptr<int> local=p;
+        int x=co_await o;
+        co_return x+*local;
+    };
+
+    EXPECT_EQ(5, *f(token, 2));
+    EXPECT_EQ(1, token.use_count());
+
+    EXPECT_FALSE((bool)f(token, nothing));
+    EXPECT_EQ(1, token.use_count());
+}
+
+TEST(coroutine, optional_move) {
+    using count=testing::ctor_count<std::string>;
+
+    auto f=[](optional<count>& lvalue) -> optional<count> {
+        count& r=co_await lvalue;
+        r.value+="!";
+        count v=co_await optional<count>(in_place, "xyz");
+        co_return v;
+    };
+
+    optional<count> a(in_place, "abc");
+    count::reset_counts();
+
+    auto b=f(a);
+    EXPECT_EQ("abc!", a->value);
+    EXPECT_EQ("xyz", b->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+}
+
+TEST(coroutine, optional_exception) {
+    auto f=[](optional<int> o) -> optional<int> {
+        int x=co_await o;
+        if (x<0) throw std::runtime_error("negative");
+        co_return x;
+    };
+
+    EXPECT_EQ(3, *f(3));
+    EXPECT_THROW(f(-3), std::runtime_error);
+}
+
+either<int, std::string> checked_div(int a, int b) {
+    if (b==0) return std::string("division by zero");
+    return a/b;
+}
+
+either<double, std::string> div_chain(int a, int b, int c) {
+    int ab=co_await checked_div(a, b);
+    int abc=co_await checked_div(ab, c);
+    co_return abc+0.5;
+}
+
+TEST(coroutine, either) {
+    auto a=div_chain(100, 5, 2);
+    ASSERT_EQ(0u, a.index());
+    EXPECT_EQ(10.5, a.get<0>());
+
+    auto b=div_chain(100, 0, 2);
+    ASSERT_EQ(1u, b.index());
+    EXPECT_EQ("division by zero", b.get<1>());
+
+    auto c=div_chain(1, 5, 0);
+    ASSERT_EQ(1u, c.index());
+    EXPECT_EQ("division by zero", c.get<1>());
+}
+
+TEST(coroutine, either_error_conversion) {
+    auto f=[](either<int, const char*> e) -> either<int, std::string> {
+        int x=co_await std::move(e);
+        co_return x*2;
+    };
+
+    auto a=f(4);
+    ASSERT_EQ(0u, a.index());
+    EXPECT_EQ(8, a.get<0>());
+
+    auto b=f("bad");
+    ASSERT_EQ(1u, b.index());
+    EXPECT_EQ("bad", b.get<1>());
+}
+
+either<int, std::unique_ptr<int>> checked(int x) {
+    if (x<0) return std::unique_ptr<int>(new int(x));
+    return x;
+}
+
+either<int, std::unique_ptr<int>> sum_checked(int a, int b) {
+    int x=co_await checked(a);
+    int y=co_await checked(b);
+    co_return x+y;
+}
+
+TEST(coroutine, either_move_error) {
+    auto a=sum_checked(1, 2);
+    ASSERT_EQ(0u, a.index());
+    EXPECT_EQ(3, a.get<0>());
+
+    auto b=sum_checked(1, -2);
+    ASSERT_EQ(1u, b.index());
+    EXPECT_EQ(-2, *b.get<1>());
+}
+
+struct no_default {
+    explicit no_default(int n): n(n) {}
+    int n;
+};
+
+TEST(coroutine, either_no_default) {
+    // The return object starts valueless, so neither field need be
+    // default constructible.
+    static_assert(std::is_same<either<no_default, std::string>,
+        decltype(std::declval<std::coroutine_traits<either<no_default, std::string>>::promise_type&>().get_return_object())>::value,
+        "promise returns the declared type");
+
+    auto f=[](either<int, std::string> e) -> either<no_default, std::string> {
+        int x=co_await std::move(e);
+        co_return no_default(x+1);
+    };
+
+    auto a=f(4);
+    ASSERT_EQ(0u, a.index());
+    EXPECT_EQ(5, a.get<0>().n);
+
+    auto b=f(std::string("bad"));
+    ASSERT_EQ(1u, b.index());
+    EXPECT_EQ("bad", b.get<1>());
+}
+
+#endif // defined(__cpp_impl_coroutine)
@@ -1,6 +1,12 @@
+#include <limits>
+#include <memory>
+#include <scoped_allocator>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include <optionalm/either.h>
+#include <optionalm/optional.h>  // lift
 
 #include "test_common.h"
 
@@ -308,3 +314,394 @@ TEST(eitherm, throw_in_assign) {
     EXPECT_NE(0u, e3.index());
     EXPECT_NE(1u, e3.index());
 }
+
+TEST(eitherm, throw_in_construct) {
+    struct throws_on_construct {
+        static int& dtor_count() { static int n=0; return n; }
+
+        throws_on_construct() { throw 0; }
+        explicit throws_on_construct(int) { throw 0; }
+        ~throws_on_construct() { ++dtor_count(); }
+    };
+
+    using e_type=either<std::string, throws_on_construct>;
+    throws_on_construct::dtor_count()=0;
+
+    EXPECT_THROW(e_type(in_place_index_t<1>{}, 3), int);
+    EXPECT_THROW(e_type(in_place_index_t<1>{}), int);
+    EXPECT_THROW(e_type(in_place, 3), int);
+    EXPECT_THROW((either<throws_on_construct, int>()), int);
+    EXPECT_EQ(0, throws_on_construct::dtor_count());
+
+    EXPECT_FALSE((std::is_nothrow_default_constructible<either<throws_on_construct, int>>::value));
+    EXPECT_FALSE((std::is_nothrow_constructible<e_type, in_place_index_t<1>, int>::value));
+    EXPECT_TRUE((std::is_nothrow_constructible<either<int, double>, in_place_index_t<1>, double>::value));
+}
+
+TEST(eitherm, nothrow_assign) {
+    using e_int_str=either<int, std::string>;
+    EXPECT_TRUE(std::is_nothrow_move_assignable<e_int_str>::value);
+    EXPECT_TRUE(std::is_nothrow_move_constructible<e_int_str>::value);
+    EXPECT_FALSE(std::is_nothrow_copy_assignable<e_int_str>::value);
+    using e_int_double=either<int, double>;
+    EXPECT_TRUE(std::is_nothrow_copy_assignable<e_int_double>::value);
+
+    using e_count=either<int, testing::ctor_count<int>>;
+    EXPECT_FALSE(std::is_nothrow_move_assignable<e_count>::value);
+}
+
+TEST(eitherm, swap) {
+    using count=testing::ctor_count<std::string>;
+    using e_type=either<int, count>;
+
+    e_type a(in_place_index_t<1>{}, "a"), b(in_place_index_t<1>{}, "b"), c(3);
+    count::reset_counts();
+
+    swap(a, b);
+    ASSERT_EQ(1u, a.index());
+    EXPECT_EQ("b", a.get<1>().value);
+    EXPECT_EQ("a", b.get<1>().value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::copy_assign_count);
+
+    swap(a, c);
+    ASSERT_EQ(0u, a.index());
+    ASSERT_EQ(1u, c.index());
+    EXPECT_EQ(3, a.get<0>());
+    EXPECT_EQ("b", c.get<1>().value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::copy_assign_count);
+
+    EXPECT_TRUE(noexcept(swap(std::declval<either<int, std::string>&>(), std::declval<either<int, std::string>&>())));
+
+    int x=1, y=2;
+    either<int&, double> rx(x), ry(y);
+    swap(rx, ry);
+    EXPECT_EQ(&y, &rx.get<0>());
+    EXPECT_EQ(&x, &ry.get<0>());
+    EXPECT_EQ(1, x);
+}
+
+TEST(eitherm, trivial) {
+    using e_int_double=either<int, double>;
+    using e_ref=either<int&, const char*>;
+    using e_string=either<int, std::string>;
+
+    static_assert(std::is_trivially_copyable<e_int_double>::value, "trivially copyable alternatives");
+    static_assert(std::is_trivially_destructible<e_int_double>::value, "trivially destructible alternatives");
+    static_assert(std::is_trivially_copyable<e_ref>::value, "reference alternatives");
+    static_assert(!std::is_trivially_copyable<e_string>::value, "non-trivial alternative");
+    static_assert(!std::is_trivially_destructible<e_string>::value, "non-trivial alternative");
+
+    static_assert(sizeof(e_int_double)==2*sizeof(double), "no overhead beyond discriminant and padding");
+    static_assert(sizeof(either<char, bool>)==2, "no overhead beyond discriminant");
+
+    e_int_double a(3), b(in_place_index_t<1>{}, 4.5);
+    e_int_double c(a);
+    ASSERT_EQ(0u, c.index());
+    EXPECT_EQ(3, c.get<0>());
+
+    c=b;
+    ASSERT_EQ(1u, c.index());
+    EXPECT_EQ(4.5, c.get<1>());
+
+    int x=1;
+    e_ref d(x), e("abc");
+    d=e;
+    ASSERT_EQ(1u, d.index());
+    EXPECT_STREQ("abc", d.get<1>());
+}
+
+TEST(eitherm, nothrow_assign_keeps_index) {
+    // With nothrow moves, assignment across fields never passes
+    // through the valueless state.
+    using e_type=either<int, std::string>;
+    e_type a(1), b(std::string("abc"));
+
+    a=b;
+    ASSERT_EQ(1u, a.index());
+    EXPECT_EQ("abc", a.get<1>());
+
+    a=e_type(2);
+    ASSERT_EQ(0u, a.index());
+    EXPECT_EQ(2, a.get<0>());
+}
+
+struct alignas(1) byte_aligned { char c; };
+
+TEST(eitherm, packed_ref) {
+    using e_ref=either<int&, double&>;
+    static_assert(sizeof(e_ref)==sizeof(void*), "discriminant packed into pointer");
+    static_assert(std::is_trivially_copyable<e_ref>::value, "packed either is trivially copyable");
+
+    using e_unpacked=either<int&, byte_aligned&>;
+    static_assert(sizeof(e_unpacked)>sizeof(void*), "no spare pointer bit");
+
+    int i=1;
+    double d=2.5;
+
+    e_ref a(i), b(d);
+    ASSERT_EQ(0u, a.index());
+    ASSERT_EQ(1u, b.index());
+    EXPECT_TRUE((bool)a);
+    EXPECT_FALSE((bool)b);
+    EXPECT_FALSE(a.valueless_by_exception());
+
+    EXPECT_EQ(&i, &a.get<0>());
+    EXPECT_EQ(&d, &b.get<1>());
+    EXPECT_THROW(a.get<1>(), bad_either_access);
+
+    a.get<0>()=3;
+    EXPECT_EQ(3, i);
+
+    a=b;
+    ASSERT_EQ(1u, a.index());
+    EXPECT_EQ(&d, &a.get<1>());
+
+    e_ref c(in_place_index_t<0>{}, i);
+    swap(b, c);
+    ASSERT_EQ(0u, b.index());
+    ASSERT_EQ(1u, c.index());
+    EXPECT_EQ(&i, &b.get<0>());
+    EXPECT_EQ(&d, &c.get<1>());
+}
+
+TEST(eitherm, match) {
+    either<int, std::string> a(3), b(std::string("four"));
+
+    auto size=[](const either<int, std::string>& e) {
+        return e.match([](int n) { return (std::size_t)n; }, [](const std::string& s) { return s.size(); });
+    };
+    EXPECT_EQ(3u, size(a));
+    EXPECT_EQ(4u, size(b));
+
+    // Results are converted to their common type.
+    double r=a.match([](int n) { return n; }, [](std::string&) { return 0.5; });
+    EXPECT_EQ(3.0, r);
+
+    b.match([](int& n) { n=0; }, [](std::string& s) { s+="!"; });
+    EXPECT_EQ("four!", b.get<1>());
+
+    // Rvalue either: fields are passed as rvalues.
+    using testing::no_copy;
+    using nc=no_copy<int>;
+    either<nc, int> c(in_place_index_t<0>{}, 5);
+    nc moved=std::move(c).match([](nc&& x) { return nc(std::move(x)); }, [](int&& n) { return nc(n); });
+    EXPECT_EQ(5, moved.value);
+
+    // Reference fields are passed as references.
+    int i=1;
+    double d=2.;
+    either<int&, double&> e(i);
+    std::move(e).match([](int& n) { n=7; }, [](double& x) { x=7.; });
+    EXPECT_EQ(7, i);
+    EXPECT_EQ(2., d);
+}
+
+TEST(eitherm, visit) {
+    struct describe {
+        std::string operator()(int) const { return "int"; }
+        std::string operator()(const std::string&) const { return "string"; }
+        std::string operator()(int, int) const { return "int,int"; }
+        std::string operator()(int, const std::string&) const { return "int,string"; }
+        std::string operator()(const std::string&, int) const { return "string,int"; }
+        std::string operator()(const std::string&, const std::string&) const { return "string,string"; }
+    };
+
+    either<int, std::string> a(3), b(std::string("four"));
+
+    EXPECT_EQ("int", hf::visit(describe{}, a));
+    EXPECT_EQ("string", hf::visit(describe{}, b));
+
+    EXPECT_EQ("int,int", hf::visit(describe{}, a, a));
+    EXPECT_EQ("int,string", hf::visit(describe{}, a, b));
+    EXPECT_EQ("string,int", hf::visit(describe{}, b, a));
+    EXPECT_EQ("string,string", hf::visit(describe{}, b, b));
+
+    // Binary visit over either types with different fields.
+    either<double, char> c('x');
+    auto sum=[](double x, double y) { return x+y; };
+    EXPECT_EQ(3.0+'x', hf::visit(sum, either<int, double>(3), c));
+    EXPECT_EQ(5.5, hf::visit(sum, either<int, double>(2), either<double, char>(3.5)));
+}
+
+TEST(eitherm, compare) {
+    using e_type=either<int, double>;
+    e_type i1(in_place_index_t<0>{}, 1), i2(in_place_index_t<0>{}, 2);
+    e_type d1(in_place_index_t<1>{}, 1.), d0(in_place_index_t<1>{}, 0.5);
+
+    EXPECT_TRUE(i1==i1);
+    EXPECT_FALSE(i1==i2);
+    EXPECT_FALSE(i1==d1);
+    EXPECT_TRUE(i1!=d1);
+    EXPECT_TRUE(i1!=i2);
+    EXPECT_FALSE(d1!=d1);
+
+    // Lower index orders first, regardless of value.
+    EXPECT_TRUE(i2<d0);
+    EXPECT_TRUE(i2<=d0);
+    EXPECT_FALSE(i2>d0);
+    EXPECT_FALSE(i2>=d0);
+    EXPECT_FALSE(d0<i2);
+    EXPECT_TRUE(d0>i2);
+
+    // Same index compares values.
+    EXPECT_TRUE(i1<i2);
+    EXPECT_TRUE(d0<d1);
+    EXPECT_FALSE(d1<d1);
+    EXPECT_TRUE(d1<=d1);
+    EXPECT_TRUE(d1>=d1);
+    EXPECT_TRUE(i2>i1);
+
+    // Comparisons use the field operators directly.
+    double nan=std::numeric_limits<double>::quiet_NaN();
+    e_type dn(in_place_index_t<1>{}, nan);
+    EXPECT_FALSE(dn==dn);
+    EXPECT_TRUE(dn!=dn);
+    EXPECT_FALSE(dn<=dn);
+    EXPECT_FALSE(dn>=dn);
+}
+
+struct ignore_args {
+    template <typename... X>
+    void operator()(const X&...) const {}
+};
+
+TEST(eitherm, compare_valueless) {
+    struct throws_on_move {
+        int value;
+        explicit throws_on_move(int v): value(v) {}
+        throws_on_move(const throws_on_move&)=default;
+        throws_on_move(throws_on_move&&) { throw 0; }
+        throws_on_move& operator=(const throws_on_move&)=default;
+        throws_on_move& operator=(throws_on_move&&) { throw 0; }
+
+        bool operator==(const throws_on_move& x) const { return value==x.value; }
+        bool operator!=(const throws_on_move& x) const { return value!=x.value; }
+        bool operator<(const throws_on_move& x) const { return value<x.value; }
+        bool operator<=(const throws_on_move& x) const { return value<=x.value; }
+        bool operator>(const throws_on_move& x) const { return value>x.value; }
+        bool operator>=(const throws_on_move& x) const { return value>=x.value; }
+    };
+
+    using e_type=either<int, throws_on_move>;
+    e_type v(0), w(0), i(3);
+    e_type t(in_place_index_t<1>{}, 2);
+
+    try { v=std::move(t); } catch (int) {}
+    try { w=std::move(t); } catch (int) {}
+    ASSERT_TRUE(v.valueless_by_exception());
+    ASSERT_TRUE(w.valueless_by_exception());
+
+    EXPECT_TRUE(v==w);
+    EXPECT_FALSE(v!=w);
+    EXPECT_FALSE(v<w);
+    EXPECT_TRUE(v<=w);
+
+    EXPECT_TRUE(v<i);
+    EXPECT_TRUE(v<t);
+    EXPECT_TRUE(t>v);
+    EXPECT_TRUE(i>=v);
+    EXPECT_FALSE(v>=i);
+    EXPECT_FALSE(v==i);
+
+    EXPECT_THROW(v.match([](int) {}, [](throws_on_move&) {}), bad_either_access);
+    EXPECT_THROW(hf::visit(ignore_args{}, i, v), bad_either_access);
+}
+
+TEST(eitherm, uses_allocator) {
+    using testing::tagged_allocator;
+    typedef testing::uses_tagged_allocator<false> leading;
+    typedef either<leading, int> E;
+
+    static_assert(std::uses_allocator<E, tagged_allocator<int>>::value, "either uses allocator");
+    static_assert(!std::uses_allocator<either<int, double>, tagged_allocator<int>>::value, "either<int, double> does not");
+
+    tagged_allocator<int> alloc(3);
+
+    E a(std::allocator_arg, alloc, in_place_index_t<0>{}, 10);
+    ASSERT_EQ(0u, a.index());
+    EXPECT_EQ(10, a.unsafe_get<0>().value);
+    EXPECT_EQ(3, a.unsafe_get<0>().alloc_id);
+
+    E b(std::allocator_arg, tagged_allocator<int>(4), a);
+    EXPECT_EQ(10, b.unsafe_get<0>().value);
+    EXPECT_EQ(4, b.unsafe_get<0>().alloc_id);
+
+    E c(std::allocator_arg, tagged_allocator<int>(5), std::move(b));
+    EXPECT_EQ(5, c.unsafe_get<0>().alloc_id);
+
+    E d(std::allocator_arg, alloc);
+    EXPECT_EQ(0u, d.index());
+    EXPECT_EQ(3, d.unsafe_get<0>().alloc_id);
+
+    either<int, leading> e(std::allocator_arg, alloc, in_place_index_t<0>{}, 7);
+    either<int, leading> f(std::allocator_arg, alloc, e);
+    ASSERT_EQ(0u, f.index());
+    EXPECT_EQ(7, f.unsafe_get<0>());
+
+    int n=1;
+    either<int&, leading> g(std::allocator_arg, alloc, n);
+    either<int&, leading> h(std::allocator_arg, alloc, g);
+    EXPECT_EQ(&n, &h.unsafe_get<0>());
+
+    typedef std::scoped_allocator_adaptor<tagged_allocator<E>> scoped;
+    std::vector<E, scoped> elements{scoped(tagged_allocator<int>(9))};
+
+    elements.emplace_back(in_place_index_t<0>{}, 1);
+    elements.emplace_back(in_place_index_t<1>{}, 2);
+    elements.push_back(a);
+    elements.reserve(10);
+
+    ASSERT_EQ(3u, elements.size());
+    EXPECT_EQ(9, elements[0].unsafe_get<0>().alloc_id);
+    EXPECT_EQ(2, elements[1].unsafe_get<1>());
+    EXPECT_EQ(9, elements[2].unsafe_get<0>().alloc_id);
+}
+
+TEST(eitherm, apply) {
+    typedef either<int, std::string> E;
+    E a(2), b(3), e1(std::string("first")), e2(std::string("second"));
+    auto add=[](int x, int y) { return x+y; };
+
+    E r=hf::apply(add, a, b);
+    ASSERT_EQ(0u, r.index());
+    EXPECT_EQ(5, r.unsafe_get<0>());
+
+    E s=hf::apply(add, a, e1);
+    ASSERT_EQ(1u, s.index());
+    EXPECT_EQ("first", s.unsafe_get<1>());
+    EXPECT_EQ("second", hf::apply(add, e2, e1).unsafe_get<1>());
+
+    // Results of a different value type; results that are eithers
+    // with the same error type are not wrapped again.
+    either<double, std::string> h=hf::apply([](int x) { return x/2.0; }, b);
+    EXPECT_EQ(1.5, h.unsafe_get<0>());
+
+    auto checked_div=[](int x, int y) { return y? E(x/y): E(std::string("division by zero")); };
+    EXPECT_EQ(1, hf::apply(checked_div, b, a).unsafe_get<0>());
+    EXPECT_EQ("division by zero", hf::apply(checked_div, a, E(0)).unsafe_get<1>());
+
+    auto add3=lift([](int x, int y, int z) { return x+y+z; });
+    EXPECT_EQ(7, add3(a, b, a).unsafe_get<0>());
+    EXPECT_EQ("first", add3(a, e1, e2).unsafe_get<1>());
+}
+
+TEST(eitherm, apply_ctor_count) {
+    using count=testing::ctor_count<std::string>;
+    typedef either<count, int> E;
+    E a(in_place_index_t<0>{}, "a"), b(in_place_index_t<0>{}, "b");
+    auto take=[](count x, count y) { return count(x.value+y.value); };
+
+    count::reset_counts();
+    either<count, int> c=hf::apply(take, std::move(a), std::move(b));
+    EXPECT_EQ("ab", c.unsafe_get<0>().value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(3, count::move_ctor_count);
+
+    count::reset_counts();
+    E d=hf::apply(take, c, E(in_place_index_t<1>{}, 4));
+    EXPECT_EQ(4, d.unsafe_get<1>());
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+}
@@ -0,0 +1,129 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/either_vector.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+TEST(either_vector, push_back) {
+    either_vector<int, std::string> v;
+    EXPECT_TRUE(v.empty());
+
+    v.push_back(1);
+    v.push_back(std::string("two"));
+    v.push_back(3);
+    either<int, std::string> four(std::string("four"));
+    v.push_back(four);
+
+    ASSERT_EQ(4u, v.size());
+    EXPECT_EQ(2u, v.count_left());
+    EXPECT_EQ(2u, v.count_right());
+
+    EXPECT_EQ(0u, v.index(0));
+    EXPECT_EQ(1u, v.index(1));
+    EXPECT_EQ(0u, v.index(2));
+    EXPECT_EQ(1u, v.index(3));
+
+    EXPECT_EQ(1, v[0].get<0>());
+    EXPECT_EQ("two", v[1].get<1>());
+    EXPECT_EQ(3, v[2].get<0>());
+    EXPECT_EQ("four", v[3].get<1>());
+
+    EXPECT_EQ((std::vector<int>{1, 3}), std::vector<int>(v.lefts().begin(), v.lefts().end()));
+    EXPECT_EQ((std::vector<std::string>{"two", "four"}), std::vector<std::string>(v.rights().begin(), v.rights().end()));
+}
+
+TEST(either_vector, element_reference) {
+    either_vector<int, double> v;
+    v.emplace_left(1);
+    v.emplace_right(2.5);
+
+    v[0].get<0>()+=10;
+    v[1].get<1>()*=2;
+    EXPECT_EQ(11, v.lefts()[0]);
+    EXPECT_EQ(5.0, v.rights()[0]);
+
+    for (int& i: v.lefts()) i*=2;
+    EXPECT_EQ(22, v[0].get<0>());
+    EXPECT_EQ(1u, v.lefts().size());
+
+    const auto& cv=v;
+    EXPECT_EQ(22, cv[0].get<0>());
+    EXPECT_THROW(cv[0].get<1>(), bad_either_access);
+}
+
+TEST(either_vector, for_each) {
+    std::vector<either<int, std::string>> src;
+    for (int i=0; i<10; ++i) {
+        if (i%3) src.push_back(i);
+        else src.push_back(std::to_string(i));
+    }
+
+    either_vector<int, std::string> v(src.begin(), src.end());
+    ASSERT_EQ(10u, v.size());
+
+    int sum=0;
+    v.for_each_left([&sum](int i) { sum+=i; });
+    EXPECT_EQ(1+2+4+5+7+8, sum);
+
+    std::string cat;
+    v.for_each_right([&cat](std::string& s) { cat+=s; });
+    EXPECT_EQ("0369", cat);
+
+    for (std::size_t i=0; i<v.size(); ++i) {
+        EXPECT_EQ(src[i].index(), v.index(i));
+    }
+}
+
+TEST(either_vector, move_and_pop) {
+    using nc_string=testing::no_copy<std::string>;
+    either_vector<int, nc_string> v;
+
+    v.push_back(either<int, nc_string>(nc_string("abc")));
+    v.push_back(either<int, nc_string>(7));
+    ASSERT_EQ(2u, v.size());
+    EXPECT_EQ("abc", v[0].get<1>().value);
+
+    v.pop_back();
+    ASSERT_EQ(1u, v.size());
+    EXPECT_EQ(0u, v.count_left());
+    EXPECT_EQ(1u, v.count_right());
+
+    v.clear();
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(0u, v.count_right());
+}
+
+TEST(either_vector, throw_in_emplace) {
+    struct throws_on_construct {
+        explicit throws_on_construct(int v) { if (v<0) throw v; }
+    };
+
+    either_vector<int, throws_on_construct> v;
+    v.emplace_left(1);
+    v.emplace_right(2);
+    EXPECT_THROW(v.emplace_right(-1), int);
+
+    ASSERT_EQ(2u, v.size());
+    EXPECT_EQ(1u, v.count_right());
+    v.emplace_left(3);
+    EXPECT_EQ(3, v[2].get<0>());
+}
+
+TEST(either_vector, many) {
+    // Appending one element at a time is amortised constant time.
+    const std::size_t n=1000000;
+    either_vector<int, double> v;
+    for (std::size_t i=0; i<n; ++i) {
+        if (i%2) v.emplace_right(0.5*i);
+        else v.emplace_left(int(i));
+    }
+
+    ASSERT_EQ(n, v.size());
+    EXPECT_EQ(n/2, v.lefts().size());
+    EXPECT_EQ(int(n-2), v[n-2].get<0>());
+    EXPECT_EQ(0.5*(n-1), v[n-1].get<1>());
+}
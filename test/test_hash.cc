@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/hash.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+TEST(hash, optional) {
+    std::hash<optional<int>> h;
+
+    EXPECT_EQ(h(optional<int>(3)), h(optional<int>(3)));
+    EXPECT_NE(h(optional<int>(3)), h(optional<int>(4)));
+    EXPECT_NE(h(optional<int>()), h(optional<int>(0)));
+
+    int i=3;
+    EXPECT_EQ(h(optional<int>(3)), std::hash<optional<int&>>()(optional<int&>(i)));
+
+    std::hash<optional<void>> hv;
+    EXPECT_NE(hv(optional<void>()), hv(optional<void>(true)));
+
+    std::unordered_set<optional<std::string>> keys;
+    keys.insert(optional<std::string>("abc"));
+    keys.insert(nothing);
+    keys.insert(optional<std::string>("abc"));
+    EXPECT_EQ(2u, keys.size());
+    EXPECT_EQ(1u, keys.count(nothing));
+    EXPECT_EQ(1u, keys.count(optional<std::string>("abc")));
+}
+
+TEST(hash, either) {
+    typedef either<int, int> e_int;
+    std::hash<e_int> h;
+
+    e_int a(in_place_index_t<0>{}, 5), b(in_place_index_t<1>{}, 5);
+    EXPECT_EQ(h(a), h(e_int(in_place_index_t<0>{}, 5)));
+    EXPECT_NE(h(a), h(b));
+
+    std::unordered_set<either<int, std::string>> keys;
+    keys.insert(either<int, std::string>(1));
+    keys.insert(either<int, std::string>(std::string("one")));
+    keys.insert(either<int, std::string>(1));
+    EXPECT_EQ(2u, keys.size());
+}
+
+TEST(hash, batch) {
+    std::vector<optional<int>> opts;
+    for (int i=0; i<100; ++i) {
+        opts.push_back(i%3? optional<int>(i): optional<int>());
+    }
+
+    std::vector<std::size_t> hashes(opts.size());
+    auto end=hash_batch(opts.begin(), opts.end(), hashes.begin());
+    EXPECT_EQ(hashes.end(), end);
+
+    std::hash<optional<int>> h;
+    for (std::size_t i=0; i<opts.size(); ++i) {
+        EXPECT_EQ(h(opts[i]), hashes[i]);
+    }
+
+    std::list<optional<int>> list(opts.begin(), opts.end());
+    std::vector<std::size_t> list_hashes;
+    hash_batch(list.begin(), list.end(), std::back_inserter(list_hashes));
+    EXPECT_EQ(hashes, list_hashes);
+
+    std::vector<optional<double>> dopts={1.5, nothing, -0.0, 0.0};
+    std::vector<std::size_t> dhashes;
+    hash_batch(dopts.begin(), dopts.end(), std::back_inserter(dhashes));
+    EXPECT_EQ(std::hash<optional<double>>()(dopts[0]), dhashes[0]);
+    EXPECT_EQ(dhashes[2], dhashes[3]);
+
+    std::vector<either<unsigned, std::string>> es;
+    for (unsigned i=0; i<20; ++i) {
+        if (i%2) es.emplace_back(i);
+        else es.emplace_back(std::to_string(i));
+    }
+
+    std::vector<std::size_t> ehashes;
+    hash_batch(es.begin(), es.end(), std::back_inserter(ehashes));
+    ASSERT_EQ(es.size(), ehashes.size());
+
+    std::hash<either<unsigned, std::string>> eh;
+    for (std::size_t i=0; i<es.size(); ++i) {
+        EXPECT_EQ(eh(es[i]), ehashes[i]);
+    }
+}
+
+// Count of keys in the fullest of `n_buckets` buckets, selected by the
+// low bits of the hash.
+static std::size_t max_bucket(const std::vector<std::size_t>& hashes, std::size_t n_buckets) {
+    std::vector<std::size_t> counts(n_buckets);
+    for (auto h: hashes) ++counts[h%n_buckets];
+    return *std::max_element(counts.begin(), counts.end());
+}
+
+TEST(hash, distribution) {
+    const std::size_t n=1<<16, n_buckets=1<<10;
+
+    // Sequential and strided keys, with and without unset values.
+    for (int stride: {1, 1024, 65536}) {
+        std::vector<optional<long>> opts;
+        for (std::size_t i=0; i<n; ++i) {
+            opts.push_back(i%7? optional<long>(long(i)*stride): optional<long>());
+        }
+        opts.push_back(optional<long>(0));
+
+        std::vector<std::size_t> hashes(opts.size());
+        hash_batch(opts.begin(), opts.end(), hashes.begin());
+
+        // Set values are distinct, and distinct from unset.
+        std::vector<std::size_t> distinct;
+        for (std::size_t i=0; i<opts.size(); ++i) {
+            if (opts[i] || i==0) distinct.push_back(hashes[i]);
+        }
+        std::sort(distinct.begin(), distinct.end());
+        EXPECT_EQ(distinct.end(), std::adjacent_find(distinct.begin(), distinct.end()));
+
+        // Expected bucket size is 64; allow generous slack.
+        std::vector<std::size_t> set_hashes;
+        for (std::size_t i=0; i<opts.size(); ++i) {
+            if (opts[i]) set_hashes.push_back(hashes[i]);
+        }
+        EXPECT_LT(max_bucket(set_hashes, n_buckets), 2*n/n_buckets);
+    }
+
+    // The same values in either field hash apart.
+    std::vector<either<int, int>> es;
+    for (int i=0; i<int(n/2); ++i) {
+        es.emplace_back(in_place_index_t<0>{}, i);
+        es.emplace_back(in_place_index_t<1>{}, i);
+    }
+
+    std::vector<std::size_t> ehashes(es.size());
+    hash_batch(es.begin(), es.end(), ehashes.begin());
+    EXPECT_LT(max_bucket(ehashes, n_buckets), 2*n/n_buckets);
+
+    std::sort(ehashes.begin(), ehashes.end());
+    EXPECT_EQ(ehashes.end(), std::adjacent_find(ehashes.begin(), ehashes.end()));
+}
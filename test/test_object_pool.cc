@@ -0,0 +1,140 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/object_pool.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+namespace {
+    struct request {
+        static std::atomic<int> live;
+        int id;
+        std::string path;
+
+        request(int id_, std::string path_): id(id_), path(std::move(path_)) {
+            if (id<0) throw std::invalid_argument("negative id");
+            ++live;
+        }
+        ~request() { --live; }
+    };
+
+    std::atomic<int> request::live(0);
+}
+
+TEST(object_pool, acquire_release) {
+    object_pool<request> pool(4);
+    EXPECT_EQ(0u, pool.capacity());
+
+    optional<request&> a=pool.acquire(1, "/a");
+    ASSERT_TRUE(a);
+    EXPECT_EQ(1, a->id);
+    EXPECT_EQ("/a", a->path);
+    EXPECT_EQ(4u, pool.capacity());
+    EXPECT_EQ(3u, pool.available());
+
+    std::vector<request*> more;
+    for (int i=0; i<6; ++i) more.push_back(&*pool.acquire(i, "/more"));
+    EXPECT_EQ(8u, pool.capacity());
+    EXPECT_EQ(7, request::live);
+
+    // A released slot is reused.
+    request* p=&*a;
+    pool.release(*a);
+    EXPECT_EQ(6, request::live);
+    EXPECT_EQ(p, &*pool.acquire(2, "/b"));
+
+    pool.release(*p);
+    for (request* r: more) pool.release(*r);
+    EXPECT_EQ(0, request::live);
+    EXPECT_EQ(8u, pool.available());
+}
+
+TEST(object_pool, limits_and_exceptions) {
+    object_pool<request> pool(2, 3);
+
+    optional<request&> a=pool.acquire(1, ""), b=pool.acquire(2, ""), c=pool.acquire(3, "");
+    ASSERT_TRUE(a && b && c);
+    EXPECT_FALSE(pool.acquire(4, ""));
+    EXPECT_EQ(3u, pool.capacity());
+
+    pool.release(*b);
+    EXPECT_THROW(pool.acquire(-1, ""), std::invalid_argument);
+    EXPECT_EQ(1u, pool.available());
+    optional<request&> d=pool.acquire(5, "");
+    ASSERT_TRUE(d);
+    EXPECT_EQ(3, request::live);
+
+    pool.release(*a);
+    pool.release(*d);
+    pool.release(*c);
+}
+
+TEST(object_pool, handle) {
+    object_pool<request> pool(2, 1);
+    {
+        object_pool<request>::handle h=pool.make(1, "/h");
+        ASSERT_TRUE(h);
+        EXPECT_EQ("/h", h->path);
+        EXPECT_FALSE(pool.make(2, "/full"));
+        EXPECT_EQ(1, request::live);
+    }
+    EXPECT_EQ(0, request::live);
+    EXPECT_EQ(1u, pool.available());
+}
+
+TEST(object_pool, cache) {
+    object_pool<request> pool(16);
+    {
+        object_pool<request>::cache cache(pool, 4);
+        optional<request&> a=cache.acquire(1, "/a");
+        ASSERT_TRUE(a);
+        EXPECT_EQ(3u, cache.cached());
+        EXPECT_EQ(12u, pool.available());
+
+        std::vector<request*> v;
+        for (int i=0; i<8; ++i) v.push_back(&*cache.acquire(i, ""));
+        for (request* r: v) cache.release(*r);
+        // At most twice the batch size is kept.
+        EXPECT_LE(cache.cached(), 8u);
+
+        // Objects may be released through the pool too.
+        pool.release(*a);
+        EXPECT_THROW(cache.acquire(-1, ""), std::invalid_argument);
+    }
+    EXPECT_EQ(0, request::live);
+    EXPECT_EQ(pool.capacity(), pool.available());
+}
+
+TEST(object_pool, concurrent) {
+    object_pool<request> pool(64);
+    const int threads=4, rounds=2000;
+
+    std::vector<std::thread> workers;
+    for (int t=0; t<threads; ++t) {
+        workers.emplace_back([&pool, t]() {
+            object_pool<request>::cache cache(pool, 8);
+            std::vector<request*> held;
+            for (int i=0; i<rounds; ++i) {
+                held.push_back(&*cache.acquire(i, "/r"));
+                if (i%3==2) {
+                    for (request* r: held) {
+                        if (r->id%2) cache.release(*r);
+                        else pool.release(*r);
+                    }
+                    held.clear();
+                }
+            }
+            for (request* r: held) cache.release(*r);
+        });
+    }
+    for (auto& w: workers) w.join();
+
+    EXPECT_EQ(0, request::live);
+    EXPECT_EQ(pool.capacity(), pool.available());
+}
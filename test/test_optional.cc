@@ -1,8 +1,18 @@
+#include <limits>
+#include <memory>
+#include <scoped_allocator>
+#include <string>
 #include <typeinfo>
+#include <vector>
 #include <array>
 #include <algorithm>
+#include <functional>
 #include <gtest/gtest.h>
 
+#if __cplusplus>=201703L
+#include <memory_resource>
+#endif
+
 #include <optionalm/optional.h>
 
 #include "test_common.h"
@@ -138,6 +148,110 @@ TEST(optional, ctor_nocopy) {
     EXPECT_EQ(1, no_copy::move_assign_count);
 }
 
+TEST(optional, ctor_in_place) {
+    using count=testing::ctor_count<std::string>;
+    count::reset_counts();
+
+    optional<count> a(in_place, 3, 'x');
+    EXPECT_EQ("xxx", a->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+
+    struct immobile {
+        int value;
+        immobile(int a, int b): value(a*b) {}
+        immobile(const immobile&)=delete;
+        immobile(immobile&&)=delete;
+    };
+
+    optional<immobile> b(in_place, 3, 4);
+    EXPECT_EQ(12, b->value);
+}
+
+TEST(optional, emplace) {
+    using count=testing::ctor_count<std::string>;
+    count::reset_counts();
+
+    optional<count> a;
+    count& r=a.emplace("abc");
+    EXPECT_TRUE((bool)a);
+    EXPECT_EQ(&r, &a.get());
+    EXPECT_EQ("abc", a->value);
+
+    a.emplace(2, 'y');
+    EXPECT_EQ("yy", a->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+    EXPECT_EQ(0, count::copy_assign_count);
+    EXPECT_EQ(0, count::move_assign_count);
+
+    struct throws_on_ctor {
+        explicit throws_on_ctor(int v) { if (v<0) throw v; }
+    };
+
+    optional<throws_on_ctor> b(in_place, 1);
+    EXPECT_THROW(b.emplace(-1), int);
+    EXPECT_FALSE((bool)b);
+}
+
+TEST(optional, nothrow_assign) {
+    struct throws_on_copy {
+        throws_on_copy() {}
+        throws_on_copy(const throws_on_copy&) {}
+        throws_on_copy& operator=(const throws_on_copy&) { return *this; }
+        throws_on_copy(throws_on_copy&&) noexcept {}
+        throws_on_copy& operator=(throws_on_copy&&) noexcept { return *this; }
+    };
+
+    EXPECT_TRUE(std::is_nothrow_move_assignable<optional<std::string>>::value);
+    EXPECT_TRUE(std::is_nothrow_copy_assignable<optional<int>>::value);
+    EXPECT_TRUE(std::is_nothrow_move_assignable<optional<throws_on_copy>>::value);
+    EXPECT_FALSE(std::is_nothrow_copy_assignable<optional<throws_on_copy>>::value);
+    EXPECT_FALSE(std::is_nothrow_move_assignable<optional<testing::ctor_count<int>>>::value);
+}
+
+TEST(optional, swap) {
+    using count=testing::ctor_count<std::string>;
+
+    optional<count> a(in_place, "a"), b(in_place, "b"), c;
+    count::reset_counts();
+
+    swap(a, b);
+    EXPECT_EQ("b", a->value);
+    EXPECT_EQ("a", b->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::copy_assign_count);
+
+    swap(a, c);
+    EXPECT_FALSE((bool)a);
+    EXPECT_EQ("b", c->value);
+
+    a.swap(c);
+    EXPECT_EQ("b", a->value);
+    EXPECT_FALSE((bool)c);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::copy_assign_count);
+
+    optional<int> d, e;
+    swap(d, e);
+    EXPECT_FALSE((bool)d);
+    EXPECT_FALSE((bool)e);
+
+    EXPECT_TRUE(noexcept(swap(d, e)));
+
+    int x=1, y=2;
+    optional<int&> rx(x), ry(y);
+    swap(rx, ry);
+    EXPECT_EQ(&y, &rx.get());
+    EXPECT_EQ(&x, &ry.get());
+    EXPECT_EQ(1, x);
+
+    optional<void> v(true), w;
+    swap(v, w);
+    EXPECT_FALSE((bool)v);
+    EXPECT_TRUE((bool)w);
+}
+
 optional<double> odd_half(int n) {
     optional<double> h;
     if (n%2==1) h=n/2.0;
@@ -164,6 +278,31 @@ TEST(optional, bind) {
     EXPECT_EQ(2.5, b.get());
 }
 
+TEST(optional, bind_rvalue) {
+    using count=testing::ctor_count<int>;
+    auto incr=[](count c) { ++c.value; return c; };
+    auto incr_opt=[](count c) { ++c.value; return optional<count>(std::move(c)); };
+
+    count::reset_counts();
+    auto a=optional<count>(count(1)) >> incr >> incr_opt >> incr >> incr_opt;
+    EXPECT_EQ(5, a->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+
+    optional<count> b(count(1));
+    count::reset_counts();
+    auto c=std::move(b).bind(incr_opt);
+    EXPECT_EQ(2, c->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(2, count::move_ctor_count);
+
+    // Binding to an lvalue still copies into a by-value argument.
+    count::reset_counts();
+    auto d=c >> incr_opt;
+    EXPECT_EQ(3, d->value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+    EXPECT_EQ(2, c->value);
+}
+
 TEST(optional, void) {
     optional<void> a, b(true), c(a), d=b, e(false);
 
@@ -303,6 +442,80 @@ TEST(optional, and_operator) {
     EXPECT_EQ(3, *b3);
 }
 
+TEST(optional, or_and_operator_move) {
+    using count=testing::ctor_count<int>;
+
+    optional<count> a(count(1)), b;
+    count::reset_counts();
+
+    auto x=std::move(b) | std::move(a);
+    EXPECT_EQ(1, x->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    count::reset_counts();
+    auto y=optional<int>(3) & optional<count>(count(2));
+    EXPECT_EQ(2, y->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+
+    count::reset_counts();
+    auto z=x | b;
+    EXPECT_EQ(1, z->value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+}
+
+TEST(optional, or_else) {
+    int calls=0;
+    auto fallback=[&calls]() { ++calls; return 7; };
+
+    optional<int> a(3), b;
+    EXPECT_EQ(3, *a.or_else(fallback));
+    EXPECT_EQ(0, calls);
+
+    EXPECT_EQ(7, *b.or_else(fallback));
+    EXPECT_EQ(1, calls);
+
+    auto c=b.or_else([]() { return nothing; });
+    EXPECT_EQ(typeid(optional<int>), typeid(c));
+    EXPECT_FALSE((bool)c);
+
+    using count=testing::ctor_count<int>;
+    optional<count> d(count(4));
+    count::reset_counts();
+
+    auto e=std::move(d).or_else([]() { return count(5); });
+    EXPECT_EQ(4, e->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    auto f=d.or_else([]() { return count(5); });
+    EXPECT_EQ(1, count::copy_ctor_count);
+}
+
+TEST(optional, and_then) {
+    int calls=0;
+    auto next=[&calls]() { ++calls; return 2.5; };
+
+    optional<int> a(3), b;
+    auto x=b.and_then(next);
+    EXPECT_EQ(typeid(optional<double>), typeid(x));
+    EXPECT_FALSE((bool)x);
+    EXPECT_EQ(0, calls);
+
+    x=a.and_then(next);
+    EXPECT_EQ(2.5, *x);
+    EXPECT_EQ(1, calls);
+
+    auto y=a.and_then([&calls]() { ++calls; });
+    EXPECT_EQ(typeid(optional<void>), typeid(y));
+    EXPECT_TRUE((bool)y);
+    EXPECT_EQ(2, calls);
+
+    auto z=provided(false).and_then([]() { return optional<int>(1); });
+    EXPECT_EQ(typeid(optional<int>), typeid(z));
+    EXPECT_FALSE((bool)z);
+}
+
 TEST(optional, provided) {
     std::array<int, 3> qs={1, 0, 3};
     std::array<int, 3> ps={14, 14, 14};
@@ -315,3 +528,281 @@ TEST(optional, provided) {
     EXPECT_EQ(-1, rs[1]);
     EXPECT_EQ(4, rs[2]);
 }
+
+TEST(optional, equality) {
+    const optional<int> a(1), b(1), c(2), u;
+
+    EXPECT_TRUE(a==b);
+    EXPECT_FALSE(a==c);
+    EXPECT_FALSE(a==u);
+    EXPECT_FALSE(u==a);
+    EXPECT_TRUE(u==optional<int>());
+    EXPECT_TRUE(a==optional<long>(1));
+    EXPECT_TRUE(a==1);
+
+    const optional<void> v(true), w(true), n;
+    EXPECT_TRUE(v==w);
+    EXPECT_FALSE(v==n);
+    EXPECT_TRUE(n==optional<void>());
+
+    EXPECT_FALSE(v==a);
+    EXPECT_FALSE(a==v);
+    EXPECT_FALSE(n==u);
+    EXPECT_TRUE(v!=a);
+    EXPECT_TRUE(u!=n);
+}
+
+TEST(optional, unset_storage_zeroed) {
+    optional<double> a;
+    EXPECT_EQ(0., detail::optional_raw_value(a));
+
+    optional<double> b(2.5);
+    b.reset();
+    EXPECT_EQ(0., detail::optional_raw_value(b));
+
+    optional<int> c(3), d;
+    c=d;
+    EXPECT_EQ(0, detail::optional_raw_value(c));
+
+    optional<int> e(4);
+    swap(d, e);
+    EXPECT_EQ(4, *d);
+    EXPECT_EQ(0, detail::optional_raw_value(e));
+}
+
+TEST(optional, ordering) {
+    const optional<int> u, a(-3), b(2), c(2);
+
+    EXPECT_TRUE(u<a);
+    EXPECT_TRUE(a<b);
+    EXPECT_FALSE(b<c);
+    EXPECT_FALSE(a<u);
+    EXPECT_FALSE(u<optional<int>());
+
+    EXPECT_TRUE(u<=u);
+    EXPECT_TRUE(u<=a);
+    EXPECT_TRUE(b<=c);
+    EXPECT_FALSE(b<=a);
+    EXPECT_FALSE(a<=u);
+
+    EXPECT_TRUE(a>u);
+    EXPECT_TRUE(b>a);
+    EXPECT_FALSE(u>a);
+    EXPECT_FALSE(u>u);
+
+    EXPECT_TRUE(u>=u);
+    EXPECT_TRUE(a>=u);
+    EXPECT_TRUE(c>=b);
+    EXPECT_FALSE(u>=a);
+
+    EXPECT_TRUE(a!=b);
+    EXPECT_TRUE(a!=u);
+    EXPECT_FALSE(b!=c);
+    EXPECT_FALSE(u!=optional<int>());
+
+    // Mixed payload types.
+    EXPECT_TRUE(a<optional<double>(-2.5));
+    EXPECT_TRUE(optional<double>(2.5)>b);
+
+    // Non-arithmetic payloads.
+    optional<std::string> s1("abc"), s2("abd"), su;
+    EXPECT_TRUE(su<s1);
+    EXPECT_TRUE(s1<s2);
+    EXPECT_TRUE(s2>=s1);
+    EXPECT_TRUE(s1!=s2);
+
+    // Unset compares less than NaN, and NaN is unordered.
+    optional<double> nan(std::numeric_limits<double>::quiet_NaN()), du;
+    EXPECT_TRUE(du<nan);
+    EXPECT_FALSE(nan<nan);
+    EXPECT_FALSE(nan<=nan);
+    EXPECT_TRUE(nan!=nan);
+
+    optional<void> vu, vs(true);
+    EXPECT_TRUE(vu<vs);
+    EXPECT_TRUE(vs>=vu);
+    EXPECT_TRUE(vs!=vu);
+
+    // An optional<void> and another optional are ordered by presence.
+    optional<int> iu, is(5);
+    EXPECT_TRUE(vu<is);
+    EXPECT_FALSE(vs<is);
+    EXPECT_TRUE(vs<=is);
+    EXPECT_FALSE(vs<=iu);
+    EXPECT_TRUE(is>vu);
+    EXPECT_FALSE(iu>vs);
+    EXPECT_TRUE(iu>=vu);
+    EXPECT_FALSE(iu>=vs);
+
+    std::vector<optional<int>> v={3, nothing, -1, 2, nothing, 0};
+    std::sort(v.begin(), v.end());
+    std::vector<optional<int>> expected={nothing, nothing, -1, 0, 2, 3};
+    EXPECT_TRUE(v==expected);
+}
+
+#if defined(__cpp_impl_three_way_comparison) && defined(__cpp_lib_three_way_comparison)
+TEST(optional, three_way) {
+    optional<int> u, a(1), b(2);
+
+    EXPECT_TRUE((u<=>a)<0);
+    EXPECT_TRUE((a<=>b)<0);
+    EXPECT_TRUE((b<=>a)>0);
+    EXPECT_TRUE((u<=>optional<int>())==0);
+    EXPECT_TRUE((a<=>optional<int>(1))==0);
+
+    optional<double> nan(std::numeric_limits<double>::quiet_NaN());
+    EXPECT_TRUE((nan<=>nan)==std::partial_ordering::unordered);
+    EXPECT_TRUE((optional<double>()<=>nan)<0);
+}
+#endif
+
+#if defined(__cpp_lib_ranges)
+// Declared with optional itself, so that the traits do not depend on
+// whether optionalm/ranges.h is also included.
+static_assert(std::ranges::view<optional<int>>, "optional is a view");
+static_assert(std::ranges::borrowed_range<optional<int&>>, "optional reference is borrowed");
+#endif
+
+TEST(optional, radix_key) {
+    std::vector<optional<int>> v={5, nothing, -7, std::numeric_limits<int>::min(), 0, std::numeric_limits<int>::max(), nothing};
+
+    for (auto& x: v) {
+        for (auto& y: v) {
+            EXPECT_EQ(x<y, radix_key(x)<radix_key(y));
+            EXPECT_EQ(x==y, radix_key(x)==radix_key(y));
+        }
+    }
+    EXPECT_EQ(0u, radix_key(optional<int>()));
+
+    optional<unsigned char> c0(0), c1(255), cu;
+    EXPECT_LT(radix_key(cu), radix_key(c0));
+    EXPECT_LT(radix_key(c0), radix_key(c1));
+
+    optional<unsigned> u0(0), umax(~0u);
+    EXPECT_LT(radix_key(u0), radix_key(umax));
+}
+
+TEST(optional, uses_allocator) {
+    using testing::tagged_allocator;
+    typedef testing::uses_tagged_allocator<false> leading;
+    typedef testing::uses_tagged_allocator<true> trailing;
+
+    static_assert(std::uses_allocator<optional<leading>, tagged_allocator<int>>::value, "optional uses allocator");
+    static_assert(!std::uses_allocator<optional<int>, tagged_allocator<int>>::value, "optional<int> does not");
+
+    tagged_allocator<int> alloc(3);
+
+    optional<leading> a(std::allocator_arg, alloc, 10);
+    ASSERT_TRUE(a);
+    EXPECT_EQ(10, a->value);
+    EXPECT_EQ(3, a->alloc_id);
+
+    optional<trailing> b(std::allocator_arg, alloc, in_place, 11);
+    EXPECT_EQ(11, b->value);
+    EXPECT_EQ(3, b->alloc_id);
+
+    optional<leading> c(std::allocator_arg, tagged_allocator<int>(4), a);
+    EXPECT_EQ(10, c->value);
+    EXPECT_EQ(4, c->alloc_id);
+
+    optional<leading> d(std::allocator_arg, tagged_allocator<int>(5), std::move(c));
+    EXPECT_EQ(5, d->alloc_id);
+
+    optional<leading> u(std::allocator_arg, alloc);
+    EXPECT_FALSE(u);
+    optional<leading> v(std::allocator_arg, alloc, optional<leading>());
+    EXPECT_FALSE(v);
+
+    // Containers pass their allocator to the elements.
+    typedef std::scoped_allocator_adaptor<tagged_allocator<optional<leading>>> scoped;
+    std::vector<optional<leading>, scoped> elements{scoped(tagged_allocator<int>(9))};
+
+    elements.emplace_back(1);
+    elements.emplace_back(nothing);
+    elements.push_back(a);
+    elements.reserve(10);
+
+    ASSERT_EQ(3u, elements.size());
+    EXPECT_EQ(9, elements[0]->alloc_id);
+    EXPECT_FALSE(elements[1]);
+    EXPECT_EQ(10, elements[2]->value);
+    EXPECT_EQ(9, elements[2]->alloc_id);
+}
+
+#if defined(__cpp_lib_memory_resource)
+TEST(optional, pmr) {
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    std::pmr::vector<optional<std::pmr::string>> v(&arena);
+    v.emplace_back("a string long enough not to fit in the small string buffer");
+    v.emplace_back(nothing);
+    v.push_back(v[0]);
+
+    EXPECT_EQ(&arena, v[0]->get_allocator().resource());
+    EXPECT_EQ(&arena, v[2]->get_allocator().resource());
+    EXPECT_EQ(*v[0], *v[2]);
+}
+#endif
+
+TEST(optional, apply) {
+    optional<int> a(2), b(3), u;
+    auto add=[](int x, int y) { return x+y; };
+
+    EXPECT_EQ(optional<int>(5), hf::apply(add, a, b));
+    EXPECT_FALSE(hf::apply(add, a, u));
+    EXPECT_FALSE(hf::apply(add, u, b));
+
+    // Results that are optional are not wrapped again.
+    auto ratio=[](int x, int y) { return y? optional<double>(double(x)/y): optional<double>(); };
+    EXPECT_EQ(optional<double>(1.5), hf::apply(ratio, b, a));
+    EXPECT_FALSE(hf::apply(ratio, a, optional<int>(0)));
+
+    int calls=0;
+    optional<void> v=hf::apply([&calls](int, int, int) { ++calls; }, a, b, a);
+    EXPECT_TRUE(v);
+    EXPECT_FALSE(hf::apply([&calls](int, int, int) { ++calls; }, a, u, a));
+    EXPECT_EQ(1, calls);
+
+    // Zero arguments: always applied.
+    EXPECT_EQ(optional<int>(7), hf::apply([]() { return 7; }));
+
+    int n=4;
+    optional<int&> r(n);
+    hf::apply([](int& x, int y) { x+=y; }, r, a);
+    EXPECT_EQ(6, n);
+}
+
+TEST(optional, apply_ctor_count) {
+    using count=testing::ctor_count<std::string>;
+    optional<count> a(count("a")), b(count("b"));
+    auto concat=[](const count& x, const count& y) { return count(x.value+y.value); };
+    auto take=[](count x, count y) { return count(x.value+y.value); };
+
+    count::reset_counts();
+    optional<count> c=hf::apply(concat, a, b);
+    EXPECT_EQ("ab", c->value);
+    // Arguments are passed by reference, and the result moved in once.
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    count::reset_counts();
+    optional<count> d=hf::apply(take, std::move(a), std::move(b));
+    EXPECT_EQ("ab", d->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(3, count::move_ctor_count);
+
+    count::reset_counts();
+    EXPECT_FALSE(hf::apply(take, c, optional<count>()));
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+}
+
+TEST(optional, lift) {
+    auto add3=lift([](int x, int y, int z) { return x+y+z; });
+    EXPECT_EQ(optional<int>(6), add3(optional<int>(1), optional<int>(2), optional<int>(3)));
+    EXPECT_FALSE(add3(optional<int>(1), optional<int>(), optional<int>(3)));
+
+    const auto neg=lift(std::negate<int>());
+    EXPECT_EQ(optional<int>(-1), neg(optional<int>(1)));
+}
@@ -0,0 +1,137 @@
+#include <string>
+#include <gtest/gtest.h>
+
+#include <optionalm/optional_fields.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+TEST(optional_fields, size) {
+    struct separate {
+        optional<int> a, b, c, d;
+        optional<double> e;
+        optional<char> f;
+    };
+    typedef optional_fields<int, int, int, int, double, char> packed;
+
+    static_assert(std::is_same<packed::mask_type, std::uint8_t>::value, "one byte mask");
+    static_assert(sizeof(packed)<sizeof(separate), "packed presence flags");
+    EXPECT_EQ(6u, packed::size());
+
+    static_assert(std::is_same<optional_fields<char, char, char, char, char, char, char, char, char>::mask_type, std::uint16_t>::value, "two byte mask");
+}
+
+TEST(optional_fields, access) {
+    optional_fields<int, std::string, double> r;
+
+    EXPECT_FALSE(r.has_any());
+    EXPECT_EQ(0u, r.count());
+    EXPECT_FALSE(r.get<0>());
+    EXPECT_FALSE(r.get<1>());
+
+    r.set<0>(3);
+    r.emplace<1>(4, 'x');
+    EXPECT_TRUE(r.has<0>());
+    EXPECT_TRUE(r.has<1>());
+    EXPECT_FALSE(r.has<2>());
+    EXPECT_EQ(2u, r.count());
+
+    ASSERT_TRUE(r.get<0>());
+    EXPECT_EQ(3, r.get<0>().get());
+    EXPECT_EQ("xxxx", r.get<1>().get());
+
+    // get returns a reference to the stored value.
+    *r.get<0>()=5;
+    EXPECT_EQ(5, *r.get<0>());
+
+    r.set<1>(std::string("abc"));
+    EXPECT_EQ("abc", *r.get<1>());
+
+    const auto& cr=r;
+    EXPECT_EQ(5, *cr.get<0>());
+    EXPECT_FALSE(cr.get<2>());
+
+    typedef decltype(r) record;
+    EXPECT_EQ(record::bit<0>() | record::bit<1>(), r.presence());
+    EXPECT_TRUE(r.has_any(record::bit<1>() | record::bit<2>()));
+    EXPECT_FALSE(r.has_any(record::bit<2>()));
+    EXPECT_TRUE(r.has_all(record::bit<0>() | record::bit<1>()));
+    EXPECT_FALSE(r.has_all(record::bit<0>() | record::bit<2>()));
+
+    r.reset<0>();
+    EXPECT_FALSE(r.has<0>());
+    EXPECT_EQ(1u, r.count());
+
+    r.reset();
+    EXPECT_FALSE(r.has_any());
+}
+
+TEST(optional_fields, copy_move) {
+    using testing::ctor_count;
+    typedef ctor_count<int> cc;
+
+    optional_fields<cc, int, cc> a;
+    a.emplace<0>(1);
+    a.set<1>(2);
+
+    cc::reset_counts();
+    auto b=a;
+    EXPECT_EQ(1, cc::copy_ctor_count);
+    EXPECT_EQ(1, b.get<0>()->value);
+    EXPECT_EQ(2, *b.get<1>());
+    EXPECT_FALSE(b.has<2>());
+
+    cc::reset_counts();
+    auto c=std::move(b);
+    EXPECT_EQ(0, cc::copy_ctor_count);
+    EXPECT_EQ(1, cc::move_ctor_count);
+    EXPECT_EQ(1, c.get<0>()->value);
+
+    // Assignment assigns fields present in both, constructs fields
+    // present only in the source, and destroys the remainder.
+    optional_fields<cc, int, cc> d;
+    d.emplace<0>(10);
+    d.emplace<2>(30);
+
+    cc::reset_counts();
+    d=a;
+    EXPECT_EQ(1, cc::copy_assign_count);
+    EXPECT_EQ(0, cc::copy_ctor_count);
+    EXPECT_EQ(a.presence(), d.presence());
+    EXPECT_EQ(1, d.get<0>()->value);
+    EXPECT_EQ(2, *d.get<1>());
+
+    optional_fields<cc, int, cc> e;
+    e.emplace<2>(3);
+
+    cc::reset_counts();
+    d=std::move(e);
+    EXPECT_EQ(1, cc::move_ctor_count);
+    EXPECT_EQ(0, cc::move_assign_count);
+    EXPECT_FALSE(d.has<0>());
+    EXPECT_FALSE(d.has<1>());
+    EXPECT_EQ(3, d.get<2>()->value);
+}
+
+TEST(optional_fields, throw_in_copy) {
+    struct throws_on_copy {
+        int value;
+        explicit throws_on_copy(int v): value(v) {}
+        throws_on_copy(const throws_on_copy& x): value(x.value) { if (value<0) throw value; }
+        throws_on_copy& operator=(const throws_on_copy&)=default;
+    };
+
+    typedef optional_fields<std::string, throws_on_copy> record;
+    record a;
+    a.emplace<0>("abc");
+    a.emplace<1>(-1);
+
+    EXPECT_THROW(record b(a), int);
+
+    record c;
+    EXPECT_THROW(c=a, int);
+    EXPECT_TRUE(c.has<0>());
+    EXPECT_FALSE(c.has<1>());
+    EXPECT_EQ("abc", *c.get<0>());
+}
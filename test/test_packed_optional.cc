@@ -0,0 +1,139 @@
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/packed_optional.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+TEST(packed_optional, bits) {
+    EXPECT_EQ(2u, packed_optional_vector<bool>::bits);
+    EXPECT_EQ(1u, (packed_optional_vector<int, 1>::bits));
+    EXPECT_EQ(2u, (packed_optional_vector<int, 3>::bits));
+    EXPECT_EQ(3u, (packed_optional_vector<int, 4>::bits));
+    EXPECT_EQ(3u, (packed_optional_vector<int, 7>::bits));
+    EXPECT_EQ(4u, (packed_optional_vector<int, 8>::bits));
+}
+
+TEST(packed_optional, bool_access) {
+    packed_optional_vector<bool> v(100);
+    EXPECT_EQ(100u, v.size());
+    EXPECT_EQ(0u, v.count_set());
+    EXPECT_FALSE(optional<bool>(v[0]));
+
+    v[3]=true;
+    v[70]=false;
+    v.push_back(true);
+    EXPECT_EQ(101u, v.size());
+
+    optional<bool> x=v[3];
+    ASSERT_TRUE(x);
+    EXPECT_TRUE(*x);
+
+    const auto& cv=v;
+    ASSERT_TRUE(cv[70]);
+    EXPECT_FALSE(*cv[70]);
+    EXPECT_TRUE(*cv[100]);
+    EXPECT_FALSE(cv[4]);
+
+    EXPECT_EQ(3u, v.count_set());
+    EXPECT_EQ(2u, v.count(true));
+    EXPECT_EQ(1u, v.count(false));
+
+    v[3]=nothing;
+    EXPECT_FALSE(cv[3]);
+    v[4]=v[70];
+    EXPECT_FALSE(*cv[4]);
+    EXPECT_EQ(1u, v.count(true));
+    EXPECT_EQ(2u, v.count(false));
+
+    // Shrinking discards trailing elements.
+    v.resize(50);
+    v.resize(101);
+    EXPECT_EQ(1u, v.count_set());
+    EXPECT_FALSE(cv[70]);
+}
+
+TEST(packed_optional, kleene) {
+    std::vector<optional<bool>> values={false, true, nothing};
+    packed_optional_vector<bool> a, b;
+    for (auto& x: values) {
+        for (auto& y: values) {
+            a.push_back(x);
+            b.push_back(y);
+        }
+    }
+
+    const auto r_and=kleene_and(a, b);
+    const auto r_or=kleene_or(a, b);
+    const auto r_not=kleene_not(a);
+
+    for (std::size_t i=0; i<a.size(); ++i) {
+        optional<bool> x=a[i], y=b[i];
+
+        optional<bool> expect_and=
+            (x && !*x) || (y && !*y)? optional<bool>(false):
+            x && y? optional<bool>(true): optional<bool>();
+        optional<bool> expect_or=
+            (x && *x) || (y && *y)? optional<bool>(true):
+            x && y? optional<bool>(false): optional<bool>();
+        optional<bool> expect_not=x? optional<bool>(!*x): optional<bool>();
+
+        EXPECT_TRUE(expect_and==r_and[i]) << i;
+        EXPECT_TRUE(expect_or==r_or[i]) << i;
+        EXPECT_TRUE(expect_not==r_not[i]) << i;
+    }
+
+    EXPECT_THROW(kleene_and(a, packed_optional_vector<bool>(3)), std::invalid_argument);
+}
+
+enum class colour { red, green, blue };
+
+TEST(packed_optional, enum_values) {
+    typedef packed_optional_vector<colour, 3> colours;
+    static_assert(colours::bits==2, "two bits for three values and unset");
+
+    colours v;
+    for (int i=0; i<200; ++i) {
+        v.push_back(i%4==3? optional<colour>(): optional<colour>(colour(i%4)));
+    }
+
+    EXPECT_EQ(150u, v.count_set());
+    EXPECT_EQ(50u, v.count(colour::red));
+    EXPECT_EQ(50u, v.count(colour::green));
+    EXPECT_EQ(50u, v.count(colour::blue));
+
+    const auto& cv=v;
+    EXPECT_TRUE(cv[5]==optional<colour>(colour::green));
+    EXPECT_FALSE(cv[7]);
+
+    v[7]=colour::blue;
+    EXPECT_EQ(51u, v.count(colour::blue));
+    EXPECT_EQ(151u, v.count_set());
+
+    typedef packed_optional_vector<unsigned char, 5> small;
+    small s(70);
+    s[65]=(unsigned char)4;
+    EXPECT_EQ(1u, s.count(4));
+    EXPECT_EQ(0u, s.count(0));
+    EXPECT_EQ(4, *small::const_reference(s[65]));
+}
+
+TEST(packed_optional, out_of_range) {
+    typedef packed_optional_vector<int, 3> small;
+    small v(4);
+    v[1]=2;
+
+    EXPECT_THROW(v.set(0, 3), std::out_of_range);
+    EXPECT_THROW(v[0]=-1, std::out_of_range);
+    EXPECT_THROW(v.push_back(7), std::out_of_range);
+    EXPECT_EQ(4u, v.size());
+    EXPECT_FALSE(v.get(0));
+
+    // No element can hold a value outside the range.
+    EXPECT_EQ(0u, v.count(3));
+    EXPECT_EQ(0u, v.count(-1));
+    EXPECT_EQ(1u, v.count(2));
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/pipeline.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+namespace {
+    optional<int> odd_only(int n) {
+        return n%2? optional<int>(n): nothing;
+    }
+
+    std::string to_string(int n) { return std::to_string(n); }
+}
+
+TEST(pipeline, single_worker) {
+    std::vector<int> input(1000);
+    std::iota(input.begin(), input.end(), 0);
+
+    pipeline_options opt;
+    opt.batch_size=7;
+    opt.queue_capacity=1;
+
+    std::vector<std::string> output;
+    run_pipeline(input.begin(), input.end(), std::back_inserter(output), opt,
+        odd_only, [](int n) { return 3*n; }, to_string);
+
+    ASSERT_EQ(500u, output.size());
+    for (std::size_t i=0; i<output.size(); ++i) {
+        EXPECT_EQ(std::to_string(3*(2*i+1)), output[i]);
+    }
+}
+
+TEST(pipeline, multiple_workers) {
+    std::vector<int> input(10000);
+    std::iota(input.begin(), input.end(), 0);
+
+    pipeline_options opt;
+    opt.batch_size=16;
+    opt.workers=4;
+
+    std::vector<int> output;
+    run_pipeline(input.begin(), input.end(), std::back_inserter(output), opt,
+        odd_only, [](int n) { return n/2; });
+
+    std::sort(output.begin(), output.end());
+    ASSERT_EQ(5000u, output.size());
+    for (int i=0; i<5000; ++i) EXPECT_EQ(i, output[i]);
+}
+
+TEST(pipeline, stage_workers) {
+    std::vector<int> input(1000);
+    std::iota(input.begin(), input.end(), 0);
+
+    pipeline_options opt;
+    opt.batch_size=1;
+    opt.stage_workers={1, 4};
+
+    std::mutex mutex;
+    std::condition_variable all_arrived;
+    std::set<std::thread::id> first_ids, second_ids;
+
+    auto first=[&](int n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        first_ids.insert(std::this_thread::get_id());
+        return n;
+    };
+
+    // Hold up the second stage until four of its threads have arrived.
+    auto second=[&](int n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        second_ids.insert(std::this_thread::get_id());
+        all_arrived.notify_all();
+        all_arrived.wait_for(lock, std::chrono::seconds(5), [&]() { return second_ids.size()>=4; });
+        return n;
+    };
+
+    std::vector<int> output;
+    run_pipeline(input.begin(), input.end(), std::back_inserter(output), opt, first, second, odd_only);
+
+    EXPECT_EQ(500u, output.size());
+    EXPECT_EQ(1u, first_ids.size());
+    EXPECT_EQ(4u, second_ids.size());
+    EXPECT_EQ(1u, opt.workers_for(2));
+}
+
+TEST(pipeline, empty) {
+    std::vector<int> input, output;
+    auto end=run_pipeline(input.begin(), input.end(), std::back_inserter(output), pipeline_options{}, odd_only);
+    (void)end;
+    EXPECT_TRUE(output.empty());
+
+    input.assign(100, 2);
+    run_pipeline(input.begin(), input.end(), std::back_inserter(output), pipeline_options{}, odd_only);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST(pipeline, move_only) {
+    using nc_int=testing::no_copy<int>;
+
+    std::vector<int> input(100);
+    std::iota(input.begin(), input.end(), 0);
+
+    std::vector<nc_int> output;
+    run_pipeline(input.begin(), input.end(), std::back_inserter(output), pipeline_options{},
+        [](int n) { return nc_int(n); },
+        [](nc_int n) { return n.value%3? optional<nc_int>(std::move(n)): nothing; });
+
+    ASSERT_EQ(66u, output.size());
+    EXPECT_EQ(1, output[0].value);
+    EXPECT_EQ(98, output.back().value);
+}
+
+TEST(pipeline, exception) {
+    std::vector<int> input(10000);
+    std::iota(input.begin(), input.end(), 0);
+
+    pipeline_options opt;
+    opt.batch_size=8;
+    opt.queue_capacity=2;
+    opt.workers=2;
+
+    std::vector<int> output;
+    auto throw_at=[](int n) {
+        if (n==5001) throw std::runtime_error("stage failure");
+        return n;
+    };
+
+    EXPECT_THROW(
+        run_pipeline(input.begin(), input.end(), std::back_inserter(output), opt, odd_only, throw_at, odd_only),
+        std::runtime_error);
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <forward_list>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/ranges.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+TEST(ranges, optional_begin_end) {
+    optional<int> a(3), b;
+
+    ASSERT_EQ(1, std::distance(a.begin(), a.end()));
+    EXPECT_EQ(&*a, a.begin());
+    EXPECT_EQ(0, std::distance(b.begin(), b.end()));
+
+    int n=0;
+    for (int& x: a) x=4, ++n;
+    for (int x: b) n+=x+1;
+    EXPECT_EQ(1, n);
+    EXPECT_EQ(4, *a);
+
+    const optional<std::string> c(std::string("c"));
+    EXPECT_EQ(std::vector<std::string>{"c"}, std::vector<std::string>(c.begin(), c.end()));
+
+    int m=5;
+    optional<int&> r(m), s;
+    for (int& x: r) x=6;
+    EXPECT_EQ(6, m);
+    EXPECT_EQ(s.begin(), s.end());
+}
+
+TEST(ranges, flatten) {
+    std::vector<optional<int>> v{1, nothing, nothing, 2, 3, nothing};
+
+    std::vector<int> r;
+    for (int x: flatten(v)) r.push_back(x);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), r);
+
+    // Elements are referenced, not copied.
+    for (int& x: flatten(v)) x*=10;
+    EXPECT_EQ(10, *v[0]);
+    EXPECT_EQ(30, *v[4]);
+    EXPECT_FALSE(v[5]);
+
+    auto f=flatten(v);
+    EXPECT_EQ(3, std::distance(f.begin(), f.end()));
+    EXPECT_EQ(&*v[3], &*std::next(f.begin()));
+
+    const std::vector<optional<int>>& cv=v;
+    EXPECT_EQ(60, std::accumulate(flatten(cv).begin(), flatten(cv).end(), 0));
+
+    std::vector<optional<int>> unset(4), empty;
+    EXPECT_TRUE(flatten(unset).empty());
+    EXPECT_TRUE(flatten(empty).empty());
+    EXPECT_FALSE(flatten(v).empty());
+
+    std::forward_list<optional<std::string>> l{nothing, std::string("a"), std::string("b")};
+    auto fl=flatten(l);
+    EXPECT_EQ((std::vector<std::string>{"a", "b"}), std::vector<std::string>(fl.begin(), fl.end()));
+
+    optional<int> o[]={nothing, 7};
+    auto fo=flatten(o);
+    EXPECT_EQ(7, *fo.begin());
+}
+
+// Input iterator yielding optional<int> by value: the value i if i is
+// even, else nothing.
+struct even_iterator {
+    typedef std::input_iterator_tag iterator_category;
+    typedef optional<int> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const optional<int>* pointer;
+    typedef optional<int> reference;
+
+    int i;
+
+    optional<int> operator*() const { return i%2? optional<int>(): optional<int>(i); }
+    even_iterator& operator++() { return ++i, *this; }
+    even_iterator operator++(int) { return even_iterator{i++}; }
+
+    bool operator==(even_iterator x) const { return i==x.i; }
+    bool operator!=(even_iterator x) const { return i!=x.i; }
+};
+
+TEST(ranges, flatten_prvalue_elements) {
+    auto f=flatten(even_iterator{1}, even_iterator{8});
+    static_assert(std::is_same<int, decltype(*f.begin())>::value, "values of prvalue elements");
+    static_assert(std::is_same<std::input_iterator_tag, decltype(f)::iterator::iterator_category>::value, "input range");
+
+    EXPECT_EQ((std::vector<int>{2, 4, 6}), std::vector<int>(f.begin(), f.end()));
+}
+
+// Forward iterator over a vector of optionals, counting the elements
+// it examines.
+struct counting_iterator {
+    typedef std::forward_iterator_tag iterator_category;
+    typedef optional<int> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const optional<int>* pointer;
+    typedef const optional<int>& reference;
+
+    static int derefs;
+    std::vector<optional<int>>::const_iterator i;
+
+    const optional<int>& operator*() const { return ++derefs, *i; }
+    counting_iterator& operator++() { return ++i, *this; }
+    counting_iterator operator++(int) { return counting_iterator{i++}; }
+
+    bool operator==(counting_iterator x) const { return i==x.i; }
+    bool operator!=(counting_iterator x) const { return i!=x.i; }
+};
+
+int counting_iterator::derefs=0;
+
+TEST(ranges, flatten_caches_begin) {
+    std::vector<optional<int>> v(100);
+    v.back()=3;
+
+    auto f=flatten(counting_iterator{v.begin()}, counting_iterator{v.end()});
+    counting_iterator::derefs=0;
+    EXPECT_EQ(3, *f.begin());
+    int first=counting_iterator::derefs;
+    EXPECT_LE(100, first);
+
+    EXPECT_EQ(3, *f.begin());
+    EXPECT_FALSE(f.empty());
+    EXPECT_EQ(1, std::distance(f.begin(), f.end()));
+    EXPECT_GT(first+10, counting_iterator::derefs);
+}
+
+TEST(ranges, lefts_rights) {
+    typedef either<int, std::string> E;
+    std::list<E> l{E(1), E(std::string("two")), E(3), E(std::string("four"))};
+
+    std::vector<int> ls;
+    for (int x: lefts(l)) ls.push_back(x);
+    EXPECT_EQ((std::vector<int>{1, 3}), ls);
+
+    std::vector<std::string> rs;
+    for (const std::string& x: rights(l)) rs.push_back(x);
+    EXPECT_EQ((std::vector<std::string>{"two", "four"}), rs);
+
+    for (int& x: lefts(l)) ++x;
+    EXPECT_EQ(2, l.front().unsafe_get<0>());
+
+    std::vector<E> none{E(std::string("x"))};
+    EXPECT_TRUE(lefts(none).empty());
+    EXPECT_FALSE(rights(none).empty());
+
+    auto rl=rights(l.begin(), l.end());
+    EXPECT_EQ(&l.back().unsafe_get<1>(), &*std::next(rl.begin()));
+}
+
+#if defined(__cpp_lib_ranges)
+TEST(ranges, std_ranges) {
+    static_assert(std::ranges::view<optional<int>>, "optional is a view");
+    static_assert(std::ranges::contiguous_range<optional<int>>, "optional is a contiguous range");
+    static_assert(std::ranges::borrowed_range<optional<int&>>, "optional reference is borrowed");
+
+    std::vector<optional<int>> v{1, nothing, 3};
+    auto f=flatten(v);
+    static_assert(std::ranges::forward_range<decltype(f)>, "flatten of vector is a forward range");
+    static_assert(std::ranges::view<decltype(f)>, "flatten is a view");
+
+    auto twice=f | std::views::transform([](int x) { return 2*x; });
+    EXPECT_EQ(6, *std::ranges::max_element(twice));
+
+    optional<int> a(5);
+    EXPECT_EQ(1, std::ranges::distance(a));
+    EXPECT_EQ(5, *std::ranges::max_element(a));
+}
+#endif
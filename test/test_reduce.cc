@@ -0,0 +1,128 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/reduce.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+// Columns of various lengths, to exercise both the lane loop and the tail.
+template <typename X>
+static std::vector<optional<X>> make_column(std::size_t n, unsigned seed) {
+    std::minstd_rand R(seed);
+    std::uniform_int_distribution<int> U(-1000, 1000);
+
+    std::vector<optional<X>> v;
+    for (std::size_t i=0; i<n; ++i) {
+        int k=U(R);
+        if (k%3) v.push_back(X(k)/X(4));
+        else v.push_back(nothing);
+    }
+    return v;
+}
+
+TEST(reduce, double_column) {
+    for (std::size_t n: {0, 1, 7, 8, 9, 100, 1001}) {
+        auto v=make_column<double>(n, n+1);
+
+        std::size_t count=0;
+        double sum=0, lo=std::numeric_limits<double>::max(), hi=std::numeric_limits<double>::lowest();
+        for (auto& x: v) {
+            if (!x) continue;
+            ++count;
+            sum+=*x;
+            lo=std::min(lo, *x);
+            hi=std::max(hi, *x);
+        }
+
+        EXPECT_EQ(count, reduce_count(v.begin(), v.end()));
+        // Values are multiples of 1/4, so sums are exact.
+        EXPECT_EQ(sum, reduce_sum(v.begin(), v.end()));
+
+        auto mn=reduce_min(v.begin(), v.end());
+        auto mx=reduce_max(v.begin(), v.end());
+        auto mean=reduce_mean(v.begin(), v.end());
+        if (count) {
+            ASSERT_TRUE(mn);
+            ASSERT_TRUE(mx);
+            ASSERT_TRUE(mean);
+            EXPECT_EQ(lo, *mn);
+            EXPECT_EQ(hi, *mx);
+            EXPECT_DOUBLE_EQ(sum/count, *mean);
+        }
+        else {
+            EXPECT_FALSE(mn);
+            EXPECT_FALSE(mx);
+            EXPECT_FALSE(mean);
+        }
+    }
+}
+
+TEST(reduce, int_column) {
+    std::vector<optional<std::int32_t>> v;
+    for (int i=0; i<50; ++i) {
+        v.push_back(i%2? optional<std::int32_t>(std::numeric_limits<std::int32_t>::max()): optional<std::int32_t>());
+    }
+    v.push_back(-5);
+
+    // Accumulation is in long long, so does not overflow.
+    auto sum=reduce_sum(v.begin(), v.end());
+    static_assert(std::is_same<decltype(sum), long long>::value, "wide accumulator");
+    EXPECT_EQ(25ll*std::numeric_limits<std::int32_t>::max()-5, sum);
+
+    EXPECT_EQ(26u, reduce_count(v.begin(), v.end()));
+    EXPECT_EQ(-5, reduce_min(v.begin(), v.end()).get());
+    EXPECT_EQ(std::numeric_limits<std::int32_t>::max(), reduce_max(v.begin(), v.end()).get());
+
+    std::vector<optional<int>> none(10);
+    EXPECT_EQ(0, reduce_sum(none.begin(), none.end()));
+    EXPECT_FALSE(reduce_min(none.begin(), none.end()));
+}
+
+TEST(reduce, nan_and_inf) {
+    double inf=std::numeric_limits<double>::infinity();
+    double nan=std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<optional<double>> v={1., nan, -2., nothing};
+    EXPECT_EQ(-2., reduce_min(v.begin(), v.end()).get());
+    EXPECT_EQ(1., reduce_max(v.begin(), v.end()).get());
+    EXPECT_TRUE(std::isnan(reduce_sum(v.begin(), v.end())));
+
+    std::vector<optional<double>> only_nan={nothing, nan};
+    EXPECT_FALSE(reduce_min(only_nan.begin(), only_nan.end()));
+
+    std::vector<optional<double>> only_inf={inf, nothing, inf};
+    EXPECT_EQ(inf, reduce_min(only_inf.begin(), only_inf.end()).get());
+    EXPECT_EQ(inf, reduce_max(only_inf.begin(), only_inf.end()).get());
+
+    std::vector<optional<double>> only_neg_inf={nothing, -inf};
+    EXPECT_EQ(-inf, reduce_min(only_neg_inf.begin(), only_neg_inf.end()).get());
+    EXPECT_EQ(-inf, reduce_max(only_neg_inf.begin(), only_neg_inf.end()).get());
+
+    // An infinite value paired with an unset one does not contribute.
+    std::vector<optional<double>> a={inf, 2., 3.};
+    std::vector<optional<double>> b={nothing, 4., 0.5};
+    EXPECT_EQ(9.5, reduce_dot(a.begin(), a.end(), b.begin()));
+}
+
+TEST(reduce, dot) {
+    for (std::size_t n: {0, 5, 8, 77}) {
+        auto a=make_column<double>(n, 3*n+1);
+        auto b=make_column<float>(n, 5*n+2);
+
+        double expected=0;
+        for (std::size_t i=0; i<n; ++i) {
+            if (a[i] && b[i]) expected+=*a[i]**b[i];
+        }
+        EXPECT_EQ(expected, reduce_dot(a.begin(), a.end(), b.begin()));
+    }
+
+    std::vector<optional<int>> p={1, 2, nothing, 4};
+    std::vector<optional<int>> q={3, nothing, 5, 6};
+    EXPECT_EQ(27, reduce_dot(p.begin(), p.end(), q.begin()));
+}
@@ -0,0 +1,155 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/either.h>
+#include <optionalm/ring_buffer.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+namespace {
+    // Not default constructible; counts live instances.
+    struct tracked {
+        static int live;
+        int value;
+
+        explicit tracked(int v): value(v) { ++live; }
+        tracked(const tracked& x): value(x.value) { ++live; }
+        tracked(tracked&& x) noexcept: value(x.value) { ++live; }
+        ~tracked() { --live; }
+    };
+
+    int tracked::live=0;
+}
+
+TEST(ring_buffer, spsc) {
+    spsc_ring<tracked> r(3);
+    EXPECT_EQ(4u, r.capacity());
+    EXPECT_TRUE(r.empty());
+    EXPECT_FALSE(r.try_pop());
+
+    for (int i=0; i<4; ++i) EXPECT_TRUE(r.try_emplace(i));
+    EXPECT_FALSE(r.try_emplace(4));
+    EXPECT_EQ(4u, r.size());
+    EXPECT_EQ(4, tracked::live);
+
+    EXPECT_EQ(0, r.try_pop()->value);
+    EXPECT_TRUE(r.try_push(tracked(4)));
+
+    for (int i=1; i<5; ++i) {
+        optional<tracked> x=r.try_pop();
+        ASSERT_TRUE(x);
+        EXPECT_EQ(i, x->value);
+    }
+    EXPECT_FALSE(r.try_pop());
+    EXPECT_EQ(0, tracked::live);
+
+    {
+        spsc_ring<tracked> s(2);
+        s.try_emplace(1);
+        s.try_emplace(2);
+        EXPECT_EQ(2, tracked::live);
+    }
+    EXPECT_EQ(0, tracked::live);
+
+    spsc_ring<std::unique_ptr<int>> u(1);
+    EXPECT_TRUE(u.try_push(std::unique_ptr<int>(new int(5))));
+    EXPECT_EQ(5, **u.try_pop());
+}
+
+TEST(ring_buffer, mpmc) {
+    mpmc_ring<tracked> r(1);
+    EXPECT_EQ(2u, r.capacity());
+
+    EXPECT_TRUE(r.try_emplace(1));
+    EXPECT_TRUE(r.try_push(tracked(2)));
+    EXPECT_FALSE(r.try_emplace(3));
+
+    EXPECT_EQ(1, r.try_pop()->value);
+    EXPECT_TRUE(r.try_emplace(3));
+    EXPECT_EQ(2, r.try_pop()->value);
+    EXPECT_EQ(3, r.try_pop()->value);
+    EXPECT_FALSE(r.try_pop());
+    EXPECT_EQ(0, tracked::live);
+
+    {
+        mpmc_ring<tracked> s(8);
+        for (int i=0; i<5; ++i) s.try_emplace(i);
+        s.try_pop();
+        EXPECT_EQ(4, tracked::live);
+    }
+    EXPECT_EQ(0, tracked::live);
+
+    // Constructed before a slot is claimed, as std::string(n, c) may throw.
+    mpmc_ring<std::string> t(4);
+    EXPECT_TRUE(t.try_emplace(3u, 'x'));
+    EXPECT_EQ("xxx", *t.try_pop());
+}
+
+TEST(ring_buffer, spsc_concurrent) {
+    typedef either<int, std::string> E;
+    spsc_ring<E> r(64);
+    const int n=100000;
+
+    std::thread producer([&]() {
+        for (int i=0; i<n; ++i) {
+            while (!(i%10? r.try_emplace(in_place_index_t<0>{}, i): r.try_emplace(in_place_index_t<1>{}, std::to_string(i)))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int next=0;
+    bool in_order=true;
+    while (next<n) {
+        optional<E> x=r.try_pop();
+        if (!x) continue;
+        int v=x->index()==0? x->unsafe_get<0>(): std::stoi(x->unsafe_get<1>());
+        in_order &= v==next++;
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(r.empty());
+}
+
+TEST(ring_buffer, mpmc_concurrent) {
+    mpmc_ring<std::unique_ptr<int>> r(32);
+    const int producers=4, consumers=4, per_producer=20000;
+    const int n=producers*per_producer;
+
+    std::vector<std::atomic<int>> seen(n);
+    for (auto& s: seen) s=0;
+    std::atomic<int> popped(0);
+
+    std::vector<std::thread> threads;
+    for (int p=0; p<producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i=0; i<per_producer; ++i) {
+                std::unique_ptr<int> x(new int(p*per_producer+i));
+                while (!r.try_push(std::move(x))) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c=0; c<consumers; ++c) {
+        threads.emplace_back([&]() {
+            while (popped<n) {
+                if (optional<std::unique_ptr<int>> x=r.try_pop()) {
+                    ++seen[**x];
+                    ++popped;
+                }
+            }
+        });
+    }
+    for (auto& t: threads) t.join();
+
+    int once=0;
+    for (auto& s: seen) once += s==1;
+    EXPECT_EQ(n, once);
+    EXPECT_TRUE(r.empty());
+}
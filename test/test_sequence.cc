@@ -0,0 +1,135 @@
+#include <forward_list>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/sequence.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+TEST(sequence, optional) {
+    std::vector<optional<int>> all{1, 2, 3}, some{1, nothing, 3}, none;
+
+    optional<std::vector<int>> s=sequence(all);
+    ASSERT_TRUE(s);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), *s);
+    EXPECT_EQ(3u, s->capacity());
+
+    EXPECT_FALSE(sequence(some));
+    EXPECT_FALSE(sequence(some.begin()+1, some.end()));
+
+    ASSERT_TRUE(sequence(none));
+    EXPECT_TRUE(sequence(none)->empty());
+
+    std::forward_list<optional<std::string>> l{std::string("a"), std::string("b")};
+    EXPECT_EQ((std::vector<std::string>{"a", "b"}), *sequence(l));
+}
+
+TEST(sequence, optional_input_iterator) {
+    // optional<int> values read from a stream, with -1 for nothing.
+    struct minus_one_unset {
+        optional<int> operator()(int x) const { return x<0? optional<int>(): optional<int>(x); }
+    };
+
+    std::istringstream ok("4 5 6"), bad("4 -1 6");
+    auto s=traverse(std::istream_iterator<int>(ok), std::istream_iterator<int>(), minus_one_unset());
+    EXPECT_EQ((std::vector<int>{4, 5, 6}), *s);
+
+    EXPECT_FALSE(traverse(std::istream_iterator<int>(bad), std::istream_iterator<int>(), minus_one_unset()));
+    // Reading stopped after the first failure.
+    int rest=0;
+    bad >> rest;
+    EXPECT_EQ(6, rest);
+}
+
+TEST(sequence, moves_payloads) {
+    std::vector<optional<std::unique_ptr<int>>> v;
+    v.emplace_back(std::unique_ptr<int>(new int(1)));
+    v.emplace_back(std::unique_ptr<int>(new int(2)));
+
+    auto s=sequence(std::move(v));
+    ASSERT_TRUE(s);
+    ASSERT_EQ(2u, s->size());
+    EXPECT_EQ(2, *(*s)[1]);
+    EXPECT_FALSE(*v[0]);
+
+    std::vector<optional<std::string>> w{std::string("x"), std::string("y")};
+    EXPECT_TRUE(sequence(w));
+    EXPECT_EQ(std::string("x"), *w[0]);
+
+    auto m=sequence(std::make_move_iterator(w.begin()), std::make_move_iterator(w.end()));
+    EXPECT_EQ((std::vector<std::string>{"x", "y"}), *m);
+}
+
+TEST(sequence, either) {
+    typedef either<int, std::string> E;
+    std::vector<E> all{E(1), E(2)}, some{E(1), E(std::string("first")), E(std::string("second"))};
+
+    auto s=sequence(all);
+    ASSERT_EQ(0u, s.index());
+    EXPECT_EQ((std::vector<int>{1, 2}), s.unsafe_get<0>());
+
+    auto t=sequence(some);
+    ASSERT_EQ(1u, t.index());
+    EXPECT_EQ("first", t.unsafe_get<1>());
+}
+
+TEST(sequence, traverse) {
+    std::vector<int> v{1, 2, 3, 4};
+    int calls=0;
+    auto half=[&calls](int x) { ++calls; return x%2? optional<int>(): optional<int>(x/2); };
+
+    EXPECT_FALSE(traverse(v, half));
+    EXPECT_EQ(1, calls);
+
+    calls=0;
+    std::vector<int> evens{2, 4, 6};
+    auto h=traverse(evens, half);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), *h);
+    EXPECT_EQ(3, calls);
+
+    typedef either<double, std::string> E;
+    auto inv=[](int x) { return x? E(1.0/x): E(std::string("division by zero at ")+std::to_string(x)); };
+    std::vector<int> w{1, 0, 2, 0};
+    auto r=traverse(w, inv);
+    ASSERT_EQ(1u, r.index());
+    EXPECT_EQ("division by zero at 0", r.unsafe_get<1>());
+}
+
+TEST(sequence, traverse_parallel) {
+    std::vector<int> v(10000);
+    for (std::size_t i=0; i<v.size(); ++i) v[i]=int(i);
+
+    traverse_options opts;
+    opts.workers=4;
+    opts.grain=64;
+
+    auto sq=[](int x) { return optional<long>(long(x)*x); };
+    auto s=traverse(v.begin(), v.end(), sq, opts);
+    ASSERT_TRUE(s);
+    ASSERT_EQ(v.size(), s->size());
+    for (std::size_t i=0; i<v.size(); ++i) ASSERT_EQ(long(i)*long(i), (*s)[i]);
+
+    // The first failure in order is reported, wherever the threads got to.
+    typedef either<int, std::size_t> E;
+    auto fail_at=[](int x) { return x%1000==999? E(in_place_index_t<1>{}, std::size_t(x)): E(x); };
+    auto r=traverse(v.begin(), v.end(), fail_at, opts);
+    ASSERT_EQ(1u, r.index());
+    EXPECT_EQ(999u, r.unsafe_get<1>());
+
+    auto thrower=[](int x) -> optional<int> {
+        if (x==5000) throw std::runtime_error("oops");
+        return x;
+    };
+    EXPECT_THROW(traverse(v.begin(), v.end(), thrower, opts), std::runtime_error);
+
+    // Small inputs are handled on the calling thread.
+    std::vector<int> small{1, 2};
+    EXPECT_EQ((std::vector<long>{1, 4}), *traverse(small.begin(), small.end(), sq, opts));
+}
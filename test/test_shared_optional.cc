@@ -0,0 +1,196 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <optionalm/shared_optional.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+namespace {
+    // Written with both fields equal; a torn read would see them differ.
+    struct pair_value {
+        long a;
+        double pad[3];
+        long b;
+    };
+
+    pair_value make_pair_value(long n) { return pair_value{n, {0, 0, 0}, n}; }
+}
+
+TEST(shared_optional, seqlock_store_load) {
+    seqlock_optional<int> s;
+    EXPECT_FALSE(s.load());
+
+    auto v0=s.version();
+    s.store(3);
+    EXPECT_EQ(optional<int>(3), s.load());
+    EXPECT_EQ(v0+2, s.version());
+
+    s.update([](optional<int>& x) { *x+=1; });
+    EXPECT_EQ(optional<int>(4), s.load());
+
+    s.reset();
+    EXPECT_FALSE(s.load());
+
+    seqlock_optional<pair_value> p(make_pair_value(7));
+    ASSERT_TRUE(p.load());
+    EXPECT_EQ(7, p.load()->b);
+}
+
+TEST(shared_optional, seqlock_concurrent) {
+    seqlock_optional<pair_value> s(make_pair_value(0));
+    std::atomic<bool> done(false);
+    std::atomic<long> torn(0);
+
+    std::vector<std::thread> readers;
+    for (int i=0; i<4; ++i) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                optional<pair_value> x=s.load();
+                if (x && x->a!=x->b) ++torn;
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int i=0; i<2; ++i) {
+        writers.emplace_back([&]() {
+            for (long n=0; n<5000; ++n) {
+                if (n%7==0) s.reset();
+                s.update([](optional<pair_value>& x) {
+                    long a=x? x->a: 0;
+                    x=make_pair_value(a+1);
+                });
+            }
+        });
+    }
+
+    for (auto& t: writers) t.join();
+    done=true;
+    for (auto& t: readers) t.join();
+
+    EXPECT_EQ(0, torn.load());
+    ASSERT_TRUE(s.load());
+}
+
+TEST(shared_optional, rcu_store_read) {
+    rcu_optional<std::string> r;
+    EXPECT_FALSE(r.load());
+
+    r.store(std::string("abc"));
+    EXPECT_EQ(3u, r.read([](const optional<std::string>& x) { return x->size(); }));
+
+    r.update([](optional<std::string>& x) { *x+="d"; });
+    EXPECT_EQ(optional<std::string>(std::string("abcd")), r.load());
+
+    r.reset();
+    EXPECT_FALSE(r.load());
+
+    // A reader that throws leaves the value readable and writable.
+    EXPECT_THROW(r.read([](const optional<std::string>& x) { return x.get(); }), optional_unset_error);
+    r.store(std::string("e"));
+    EXPECT_EQ(std::string("e"), *r.load());
+}
+
+TEST(shared_optional, rcu_concurrent) {
+    // Values are strings of n copies of the character 'a'+n%26; a reader
+    // of a freed or partly written value would see an inconsistent one.
+    rcu_optional<std::string> r{std::string()};
+    std::atomic<bool> done(false);
+    std::atomic<long> bad(0);
+
+    std::vector<std::thread> readers;
+    for (int i=0; i<6; ++i) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                r.read([&](const optional<std::string>& x) {
+                    if (!x) return;
+                    std::size_t n=x->size();
+                    for (char c: *x) if (c!=char('a'+n%26)) ++bad;
+                });
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int i=0; i<2; ++i) {
+        writers.emplace_back([&]() {
+            for (int k=0; k<500; ++k) {
+                if (k%5==0) r.reset();
+                r.update([](optional<std::string>& x) {
+                    std::size_t n=x? x->size()+1: 1;
+                    x=std::string(n, char('a'+n%26));
+                });
+            }
+        });
+    }
+
+    for (auto& t: writers) t.join();
+    done=true;
+    for (auto& t: readers) t.join();
+
+    EXPECT_EQ(0, bad.load());
+    ASSERT_TRUE(r.load());
+}
+
+TEST(shared_optional, rcu_concurrent_store) {
+    // Readers of two values, on threads that come and go so that reader
+    // records are reused, run alongside writers that store and update
+    // both values. Each value holds n copies of the digit n%10.
+    rcu_optional<std::string> r[2];
+    std::atomic<bool> done(false);
+    std::atomic<long> bad(0);
+
+    auto check=[&](const optional<std::string>& x) {
+        if (!x) return;
+        std::size_t n=x->size();
+        for (char c: *x) if (c!=char('0'+n%10)) ++bad;
+    };
+
+    std::vector<std::thread> readers;
+    for (int i=0; i<4; ++i) {
+        readers.emplace_back([&, i]() {
+            while (!done) {
+                std::thread t([&]() {
+                    for (int k=0; k<100; ++k) {
+                        r[(i+k)%2].read(check);
+                        r[(i+k+1)%2].read([&](const optional<std::string>& x) {
+                            check(x);
+                            r[(i+k)%2].read(check);
+                        });
+                    }
+                });
+                t.join();
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int i=0; i<3; ++i) {
+        writers.emplace_back([&, i]() {
+            for (int k=0; k<300; ++k) {
+                rcu_optional<std::string>& w=r[(i+k)%2];
+                if (k%3==0) {
+                    std::size_t n=k%20;
+                    w.store(std::string(n, char('0'+n%10)));
+                }
+                else {
+                    w.update([](optional<std::string>& x) {
+                        std::size_t n=x? x->size()+1: 0;
+                        x=std::string(n, char('0'+n%10));
+                    });
+                }
+            }
+        });
+    }
+
+    for (auto& t: writers) t.join();
+    done=true;
+    for (auto& t: readers) t.join();
+
+    EXPECT_EQ(0, bad.load());
+}
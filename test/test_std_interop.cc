@@ -0,0 +1,147 @@
+#include <string>
+#include <gtest/gtest.h>
+
+#include <optionalm/std_interop.h>
+
+#include "test_common.h"
+
+using namespace hf;
+
+#if __cplusplus>=201703L
+
+TEST(std_interop, optional) {
+    using count=testing::ctor_count<std::string>;
+
+    std::optional<count> s(std::in_place, "a"), u;
+
+    count::reset_counts();
+    optional<count> a=from_std(s);
+    EXPECT_EQ("a", a->value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+
+    count::reset_counts();
+    optional<count> b=from_std(std::move(s));
+    EXPECT_EQ("a", b->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    EXPECT_FALSE(from_std(u));
+
+    count::reset_counts();
+    std::optional<count> c=to_std_optional(a);
+    std::optional<count> d=to_std_optional(std::move(b));
+    EXPECT_EQ("a", c->value);
+    EXPECT_EQ("a", d->value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    EXPECT_FALSE(to_std_optional(optional<count>()));
+}
+
+TEST(std_interop, borrow_optional) {
+    using count=testing::ctor_count<std::string>;
+    std::optional<count> s(std::in_place, "a"), u;
+
+    count::reset_counts();
+    optional<count&> r=borrow(s);
+    ASSERT_TRUE(r);
+    EXPECT_EQ(&*s, &*r);
+    r->value="b";
+    EXPECT_EQ("b", s->value);
+
+    const std::optional<count>& cs=s;
+    optional<const count&> cr=borrow(cs);
+    EXPECT_EQ(&*s, &*cr);
+    EXPECT_FALSE(borrow(u));
+
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+}
+
+TEST(std_interop, variant) {
+    using count=testing::ctor_count<std::string>;
+    typedef std::variant<int, count> V;
+    typedef either<int, count> E;
+
+    V v(std::in_place_index<1>, "v");
+
+    count::reset_counts();
+    E a=from_std(v);
+    E b=from_std(std::move(v));
+    ASSERT_EQ(1u, a.index());
+    EXPECT_EQ("v", a.unsafe_get<1>().value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    count::reset_counts();
+    V w=to_variant(a);
+    V x=to_variant(std::move(b));
+    ASSERT_EQ(1u, x.index());
+    EXPECT_EQ("v", std::get<1>(x).value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    EXPECT_EQ(3, from_std(V(3)).unsafe_get<0>());
+    EXPECT_EQ(4, std::get<0>(to_variant(E(4))));
+
+    // Alternatives of the same type are distinguished by index.
+    std::variant<int, int> same(std::in_place_index<1>, 5);
+    EXPECT_EQ(1u, from_std(same).index());
+    EXPECT_EQ(1u, to_variant(from_std(same)).index());
+}
+
+TEST(std_interop, borrow_variant) {
+    using count=testing::ctor_count<std::string>;
+    std::variant<int, count> v(std::in_place_index<1>, "v");
+
+    count::reset_counts();
+    either<int&, count&> r=borrow(v);
+    ASSERT_EQ(1u, r.index());
+    EXPECT_EQ(&std::get<1>(v), &r.unsafe_get<1>());
+
+    const auto& cv=v;
+    either<const int&, const count&> cr=borrow(cv);
+    EXPECT_EQ(&std::get<1>(v), &cr.unsafe_get<1>());
+
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(0, count::move_ctor_count);
+
+    v=7;
+    borrow(v).unsafe_get<0>()=8;
+    EXPECT_EQ(8, std::get<0>(v));
+}
+
+#if defined(__cpp_lib_expected)
+TEST(std_interop, expected) {
+    using count=testing::ctor_count<std::string>;
+    typedef std::expected<count, int> X;
+    typedef either<count, int> E;
+
+    X x(std::in_place, "x"), err(std::unexpect, 3);
+
+    count::reset_counts();
+    E a=from_std(x);
+    E b=from_std(std::move(x));
+    EXPECT_EQ("x", a.unsafe_get<0>().value);
+    EXPECT_EQ(1, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+
+    E e=from_std(err);
+    ASSERT_EQ(1u, e.index());
+    EXPECT_EQ(3, e.unsafe_get<1>());
+
+    count::reset_counts();
+    X y=to_expected(std::move(b));
+    EXPECT_EQ("x", y->value);
+    EXPECT_EQ(0, count::copy_ctor_count);
+    EXPECT_EQ(1, count::move_ctor_count);
+    EXPECT_EQ(3, to_expected(e).error());
+
+    either<count&, int&> r=borrow(y);
+    EXPECT_EQ(&*y, &r.unsafe_get<0>());
+    EXPECT_EQ(&err.error(), &borrow(err).unsafe_get<1>());
+}
+#endif
+
+#endif // __cplusplus>=201703L
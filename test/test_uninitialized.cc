@@ -1,5 +1,9 @@
+#include <memory>
+#include <string>
 #include <gtest/gtest.h>
 
+#include <optionalm/either.h>
+#include <optionalm/optional.h>
 #include <optionalm/uninitialized.h>
 
 #include "test_common.h"
@@ -144,3 +148,90 @@ TEST(uninitialized, void_apply) {
 
     EXPECT_EQ(12.5, uv.apply([]() { return 12.5; }));
 }
+
+TEST(uninitialized, trivially_relocatable) {
+    EXPECT_TRUE(is_trivially_relocatable<int>::value);
+    EXPECT_TRUE(is_trivially_relocatable<int&>::value);
+    EXPECT_TRUE(is_trivially_relocatable<std::unique_ptr<int>>::value);
+    EXPECT_FALSE(is_trivially_relocatable<testing::ctor_count<int>>::value);
+
+    EXPECT_TRUE(is_trivially_relocatable<uninitialized<int>>::value);
+    EXPECT_FALSE(is_trivially_relocatable<uninitialized<testing::ctor_count<int>>>::value);
+
+    EXPECT_TRUE(is_trivially_relocatable<optional<double>>::value);
+    EXPECT_TRUE(is_trivially_relocatable<optional<std::unique_ptr<int>>>::value);
+    EXPECT_TRUE(is_trivially_relocatable<optional<void>>::value);
+    EXPECT_FALSE(is_trivially_relocatable<optional<testing::ctor_count<int>>>::value);
+
+    using e_ptr_int=either<std::unique_ptr<int>, int>;
+    using e_count_int=either<testing::ctor_count<int>, int>;
+    EXPECT_TRUE(is_trivially_relocatable<e_ptr_int>::value);
+    EXPECT_FALSE(is_trivially_relocatable<e_count_int>::value);
+}
+
+TEST(uninitialized, relocate) {
+    using opt_ptr=optional<std::unique_ptr<int>>;
+    uninitialized<opt_ptr> from[3], to[3];
+
+    from[0].construct(std::unique_ptr<int>(new int(0)));
+    from[1].construct(nothing);
+    from[2].construct(std::unique_ptr<int>(new int(2)));
+
+    opt_ptr* end=relocate(from[0].ptr(), from[0].ptr()+3, to[0].ptr());
+    EXPECT_EQ(to[0].ptr()+3, end);
+
+    EXPECT_EQ(0, **to[0].ref());
+    EXPECT_FALSE((bool)to[1].ref());
+    EXPECT_EQ(2, **to[2].ref());
+
+    for (auto& u: to) u.destruct();
+}
+
+TEST(uninitialized, relocate_nontrivial) {
+    using count=testing::ctor_count<std::string>;
+    uninitialized<optional<count>> from[2], to[2];
+
+    from[0].construct(in_place, "abc");
+    from[1].construct(nothing);
+    count::reset_counts();
+
+    relocate(from[0].ptr(), from[0].ptr()+2, to[0].ptr());
+    EXPECT_EQ(1, count::move_ctor_count);
+    EXPECT_EQ(0, count::copy_ctor_count);
+
+    EXPECT_EQ("abc", to[0].ref()->value);
+    EXPECT_FALSE((bool)to[1].ref());
+
+    for (auto& u: to) u.destruct();
+}
+
+TEST(uninitialized, construct_using_allocator) {
+    using testing::tagged_allocator;
+    typedef testing::uses_tagged_allocator<false> leading;
+    typedef testing::uses_tagged_allocator<true> trailing;
+
+    tagged_allocator<int> alloc(7);
+
+    uninitialized<leading> ul;
+    ul.construct_using_allocator(alloc, 3);
+    EXPECT_EQ(3, ul.cref().value);
+    EXPECT_EQ(7, ul.cref().alloc_id);
+    ul.destruct();
+
+    uninitialized<trailing> ut;
+    ut.construct_using_allocator(alloc, 4);
+    EXPECT_EQ(4, ut.cref().value);
+    EXPECT_EQ(7, ut.cref().alloc_id);
+    ut.destruct();
+
+    // Types that do not use the allocator are constructed without it.
+    uninitialized<std::string> us;
+    us.construct_using_allocator(alloc, 3, 'a');
+    EXPECT_EQ("aaa", us.cref());
+    us.destruct();
+
+    int i=5;
+    uninitialized<int&> ur;
+    ur.construct_using_allocator(alloc, i);
+    EXPECT_EQ(&i, ur.ptr());
+}